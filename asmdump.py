@@ -1,4 +1,15 @@
 Import("env", "projenv")
+import os
+import subprocess
+
+# Outils de la chaîne de compilation (même répertoire que objcopy)
+OBJDUMP = env.subst("$OBJCOPY").replace("objcopy", "objdump")
+NM = env.subst("$OBJCOPY").replace("objcopy", "nm")
+
+# Taille des mémoires de l'ATmega328P (flash sans le bootloader)
+FLASH_SIZE = 32256
+RAM_SIZE = 2048
+
 # Ajout de l'option -g aux indicateurs du linker pour obtenir le code source dans le fichier elf.
 env.Append(LINKFLAGS=["-g"])
 
@@ -6,7 +17,7 @@ env.Append(LINKFLAGS=["-g"])
 env.AddCustomTarget(
     "asm_dump",
     "$BUILD_DIR/${PROGNAME}.elf",
-    "C:/.platformio/packages/toolchain-atmelavr/avr/bin/objdump -D -S $BUILD_DIR/${PROGNAME}.elf > $BUILD_DIR/${PROGNAME}.asm",
+    OBJDUMP + " -D -S $BUILD_DIR/${PROGNAME}.elf > $BUILD_DIR/${PROGNAME}.asm",
     "Dump ELF to ASM",
     "Dump de firmware.elf vers firmware.asm (source + ASM résultant de la compilation)."
 )
@@ -14,8 +25,51 @@ env.AddCustomTarget(
 # Fonction de call back pour extraire le code asm compilé avec le code source
 def asmAvecSourceCB(source, target, env):
     print("Dump firmware.elf ...")
-    env.Execute("C:/.platformio/packages/toolchain-atmelavr/avr/bin/objdump -D -S $BUILD_DIR/${PROGNAME}.elf > $BUILD_DIR/${PROGNAME}.asm")
+    env.Execute(OBJDUMP + " -D -S $BUILD_DIR/${PROGNAME}.elf > $BUILD_DIR/${PROGNAME}.asm")
     # do some actions
 
 # Ajout d'une fonction de call back a exécuté lorsque le fichier firmware.elf est créé.
-env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", asmAvecSourceCB)
\ No newline at end of file
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", asmAvecSourceCB)
+
+# Rapport de l'occupation mémoire symbole par symbole (firmware.mem)
+def memoryReportCB(source, target, env):
+    elf = env.subst("$BUILD_DIR/${PROGNAME}.elf")
+    output = subprocess.check_output([NM, "--size-sort", "-S", "-C", "--radix=d", elf],
+                                     universal_newlines=True)
+    flash = []
+    ram = []
+    for line in output.splitlines():
+        fields = line.split(None, 3)
+        if len(fields) < 4:
+            continue
+        size = int(fields[1])
+        kind = fields[2].lower()
+        name = fields[3]
+        if kind in ("t", "w"):
+            flash.append((size, name))
+        elif kind == "d":
+            # Les variables initialisées occupent la RAM et leur valeur la flash
+            flash.append((size, name))
+            ram.append((size, name))
+        elif kind == "b":
+            ram.append((size, name))
+    lines = []
+    for title, symbols, total in (("FLASH", flash, FLASH_SIZE), ("RAM", ram, RAM_SIZE)):
+        used = sum(size for size, name in symbols)
+        lines.append("%s: %d / %d bytes (%.1f %%)" % (title, used, total, 100.0 * used / total))
+        for size, name in sorted(symbols, reverse=True):
+            lines.append("%8d  %s" % (size, name))
+        lines.append("")
+    report = os.path.join(env.subst("$BUILD_DIR"), env.subst("${PROGNAME}.mem"))
+    with open(report, "w") as f:
+        f.write("\n".join(lines))
+    print("\n".join(lines[:20]))
+    print("Full report: " + report)
+
+env.AddCustomTarget(
+    "mem_report",
+    "$BUILD_DIR/${PROGNAME}.elf",
+    memoryReportCB,
+    "Memory report",
+    "Occupation FLASH/RAM par symbole (firmware.mem)."
+)
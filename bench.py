@@ -0,0 +1,109 @@
+# Mesure des chemins critiques du firmware (build -DBENCHMARK) sous simavr.
+#
+# Utilisation :
+#   pio run -e bench -t bench            (depuis PlatformIO)
+#   python bench.py firmware.elf [--update]
+#
+# Le firmware envoie une ligne "BENCH <nom> <cycles>" par fonction mesurée.
+# Le rapport est écrit dans bench_report.json. Chaque mesure est comparée à la
+# référence (bench_baseline.json, suivie dans git) et le script échoue si elle
+# la dépasse de plus de TOLERANCE, si une mesure n'a pas de référence ou s'il
+# n'y a pas de référence du tout. --update remplace la référence par la mesure.
+import json
+import os
+import re
+import subprocess
+import sys
+
+SIMAVR = os.environ.get("SIMAVR", "simavr")
+MCU = "atmega328p"
+FREQUENCY = "16000000"
+TOLERANCE = 0.05    # 5 %
+TIMEOUT = 120       # secondes
+BASELINE = "bench_baseline.json"
+REPORT = "bench_report.json"
+
+def run_simavr(elf):
+    """Lance le firmware sous simavr et retourne les mesures {nom: cycles}."""
+    results = {}
+    proc = subprocess.Popen([SIMAVR, "-m", MCU, "-f", FREQUENCY, elf],
+                            stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                            universal_newlines=True)
+    try:
+        for line in proc.stdout:
+            if "BENCH END" in line:
+                break
+            match = re.search(r"BENCH (\S+) (\d+)", line)
+            if match:
+                results[match.group(1)] = int(match.group(2))
+    finally:
+        proc.kill()
+        proc.wait(TIMEOUT)
+    return results
+
+def compare(results, baseline):
+    """Retourne la liste des régressions par rapport à la référence."""
+    regressions = []
+    for name, cycles in sorted(results.items()):
+        ref = baseline.get(name)
+        if ref is None:
+            status = "SANS REFERENCE"
+        else:
+            status = "OK" if cycles <= int(ref * (1 + TOLERANCE)) else "REGRESSION"
+        print("%-20s %8d cycles  (ref %s)  %s" % (name, cycles, ref, status))
+        if status != "OK":
+            regressions.append(name)
+    return regressions
+
+def bench(elf, directory, update=False):
+    results = run_simavr(elf)
+    if not results:
+        print("Aucune mesure reçue de simavr")
+        return 1
+    baseline_path = os.path.join(directory, BASELINE)
+    baseline = {}
+    if not update:
+        if not os.path.exists(baseline_path):
+            print("Pas de référence (%s) : la créer avec --update et la suivre dans git" % BASELINE)
+            return 1
+        with open(baseline_path) as f:
+            baseline = json.load(f)
+        regressions = compare(results, baseline)
+    else:
+        regressions = []
+        for name, cycles in sorted(results.items()):
+            print("%-20s %8d cycles" % (name, cycles))
+    with open(os.path.join(directory, REPORT), "w") as f:
+        json.dump({"mcu": MCU, "frequency": int(FREQUENCY), "tolerance": TOLERANCE,
+                   "cycles": results, "baseline": baseline,
+                   "regressions": regressions}, f, indent=2, sort_keys=True)
+    if update:
+        with open(baseline_path, "w") as f:
+            json.dump(results, f, indent=2, sort_keys=True)
+    return 1 if regressions else 0
+
+try:
+    Import("env")
+except NameError:
+    env = None
+
+if env is None:
+    args = [a for a in sys.argv[1:] if not a.startswith("--")]
+    if not args:
+        print("Usage: python bench.py firmware.elf [--update]")
+        sys.exit(2)
+    sys.exit(bench(args[0], os.getcwd(), "--update" in sys.argv))
+else:
+    # Ajout d'une cible "bench" dans le menu Custom de PIO
+    def benchCB(source, target, env):
+        elf = env.subst("$BUILD_DIR/${PROGNAME}.elf")
+        if bench(elf, env.subst("$PROJECT_DIR")) != 0:
+            env.Exit(1)
+
+    env.AddCustomTarget(
+        "bench",
+        "$BUILD_DIR/${PROGNAME}.elf",
+        benchCB,
+        "Benchmark",
+        "Mesure des chemins critiques sous simavr (rapport dans bench_report.json)."
+    )
@@ -0,0 +1,142 @@
+# Modèle d'énergie du StepEmulator, à partir des compteurs du firmware.
+#
+# Utilisation :
+#   python energy.py "OK 0 12 ... 2000"          (réponse de la commande série E)
+#   program 2000 100 | python energy.py          (sortie du simulateur, ou journal série)
+#   python energy.py --plan 20000 120 [--settle 25] [--dim 4]
+#   ... [--capacity 2000]                        (autonomie pour une capacité en mAh)
+#
+# Les compteurs (voir src/energyHelper.h) sont le temps passé dans chaque état,
+# le temps où le servo est attaché, où l'affichage est allumé (ramené à la
+# pleine luminosité), où le buzzer sonne, et le nombre de pas. Chaque charge
+# est multipliée par son courant (CURRENTS, à ajuster pour la carte), ce qui
+# donne les mAh de la session par état et par sous-système. Le sous-système
+# qui consomme le plus est celui à optimiser en premier.
+# --plan prédit ces compteurs pour une session (pas et cadence) avant de la lancer.
+import re
+import sys
+
+# Courants en mA (Arduino Uno en 5 V, servo SG90, afficheur 5 chiffres multiplexé)
+CURRENTS = {
+    "mcu": 20.0,            # Carte éveillée (microcontrôleur, régulateur, interface USB)
+    "servo_hold": 8.0,      # Servo attaché qui tient sa position
+    "display": 40.0,        # Afficheur à pleine luminosité
+    "buzzer": 25.0,         # Buzzer qui sonne
+}
+# Charge d'un mouvement du servo (mA.s par demi-pas : ~250 mA pendant ~150 ms)
+SERVO_MOVE_MAS = 37.5
+
+# États de stateMachine::States, dans l'ordre des compteurs (à partir de PowerOff)
+STATES = ["PowerOff", "Init", "SetSteps", "AdjustSteps", "Emulate", "Paused",
+          "ChangeSpeed", "Finished", "EditConfig"]
+COUNTERS = len(STATES) + 4
+
+# Constantes du firmware pour --plan (movementsHelper.h, userinterfaceHelper.h)
+REARM_LEAD_MS = 40
+MIN_RELEASE_MS = 100
+DIM_DELAY_MS = 30000
+BRIGHTNESS_MAX = 16
+
+def parse_counters(text):
+    """Retourne les derniers compteurs trouvés dans le texte (réponse OK de E), ou None."""
+    found = None
+    for match in re.finditer(r"OK((?: \d+){%d})\b" % COUNTERS, text):
+        found = [int(v) for v in match.group(1).split()]
+    if found is None:
+        return None
+    return {
+        "states": dict(zip(STATES, found[:len(STATES)])),
+        "servo": found[len(STATES)],
+        "display": found[len(STATES) + 1],
+        "buzzer": found[len(STATES) + 2],
+        "steps": found[len(STATES) + 3],
+    }
+
+def plan_counters(steps, speed, settle, dim):
+    """Compteurs prévus pour une session de `steps` pas à `speed` pas/min."""
+    half_ms = 30000.0 / speed
+    duration = 2 * steps * half_ms
+    # Servo relâché entre deux demi-pas s'il a le temps (voir movements::gateServo)
+    hold = settle * 10.0
+    if (settle > 0) and (half_ms - hold > REARM_LEAD_MS + MIN_RELEASE_MS):
+        servo = 2 * steps * (hold + REARM_LEAD_MS)
+    else:
+        servo = duration
+    # Pleine luminosité, puis baisse après DIM_DELAY_MS sans toucher le bouton
+    bright = min(duration, DIM_DELAY_MS)
+    display = bright + (duration - bright) * dim / BRIGHTNESS_MAX
+    states = dict.fromkeys(STATES, 0)
+    states["Emulate"] = int(duration)
+    return {"states": states, "servo": int(servo), "display": int(display),
+            "buzzer": 0, "steps": steps}
+
+def model(counters):
+    """Charge de chaque sous-système (mAh) et de chaque état (mAh de la carte éveillée)."""
+    to_mah = 1.0 / 3600000.0    # mA.ms -> mAh
+    by_state = {s: ms * CURRENTS["mcu"] * to_mah for s, ms in counters["states"].items()}
+    subsystems = {
+        "mcu": sum(by_state.values()),
+        "servo (maintien)": counters["servo"] * CURRENTS["servo_hold"] * to_mah,
+        "servo (mouvements)": 2 * counters["steps"] * SERVO_MOVE_MAS / 3600.0,
+        "affichage": counters["display"] * CURRENTS["display"] * to_mah,
+        "buzzer": counters["buzzer"] * CURRENTS["buzzer"] * to_mah,
+    }
+    return subsystems, by_state
+
+def report(counters, capacity):
+    subsystems, by_state = model(counters)
+    total = sum(subsystems.values())
+    awake = sum(counters["states"].values())
+    print("Temps éveillé   : %.1f s, %d pas" % (awake / 1000.0, counters["steps"]))
+    print("Par état (carte éveillée) :")
+    for state in STATES:
+        ms = counters["states"][state]
+        if ms > 0:
+            print("  %-14s %10.1f s %9.3f mAh" % (state, ms / 1000.0, by_state[state]))
+    print("Par sous-système :")
+    ranking = sorted(subsystems.items(), key=lambda item: item[1], reverse=True)
+    for name, mah in ranking:
+        share = 100.0 * mah / total if total > 0 else 0.0
+        print("  %-20s %9.3f mAh %5.1f %%" % (name, mah, share))
+    print("Total           : %.3f mAh" % total)
+    if total > 0:
+        print("À optimiser     : %s" % ranking[0][0])
+    if (capacity > 0) and (total > 0) and (awake > 0):
+        hours = capacity / (total * 3600000.0 / awake)
+        print("Autonomie       : %.1f sessions, %.1f h (%d mAh)" % (capacity / total, hours, capacity))
+
+def main(args):
+    capacity = 0
+    settle = 25
+    dim = 4
+    plan = None
+    text = []
+    i = 0
+    while i < len(args):
+        if args[i] == "--plan" and i + 2 < len(args):
+            plan = (int(args[i + 1]), int(args[i + 2]))
+            i += 2
+        elif args[i] == "--settle" and i + 1 < len(args):
+            settle = int(args[i + 1])
+            i += 1
+        elif args[i] == "--dim" and i + 1 < len(args):
+            dim = int(args[i + 1])
+            i += 1
+        elif args[i] == "--capacity" and i + 1 < len(args):
+            capacity = int(args[i + 1])
+            i += 1
+        else:
+            text.append(args[i])
+        i += 1
+    if plan is not None:
+        counters = plan_counters(plan[0], plan[1], settle, dim)
+    else:
+        counters = parse_counters(" ".join(text) if text else sys.stdin.read())
+        if counters is None:
+            print("Aucun compteur (réponse OK de la commande E) trouvé")
+            return 1
+    report(counters, capacity)
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
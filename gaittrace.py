@@ -0,0 +1,174 @@
+# Conversion d'une trace de marche enregistrée (CSV) en table PROGMEM compressée.
+#
+# Utilisation :
+#   python gaittrace.py [trace.csv [gaitTrace.h]]
+#   (lancé automatiquement avant chaque build PlatformIO : extra_scripts = pre:gaittrace.py)
+#
+# Le CSV contient une ligne par mesure : "temps_ms,position[,appui]"
+#  - position : position du téléphone sur la course (unité quelconque,
+#    le minimum correspond au pied posé, le maximum au pied levé)
+#  - appui : 1 sur les mesures où le pied touche le sol (optionnel, sinon
+#    les appuis sont détectés quand la position redescend sous le quart de la course)
+# Les lignes qui ne commencent pas par un nombre sont ignorées.
+#
+# La trace est rééchantillonnée à une trame servo (20 ms), ramenée sur 0..255,
+# coupée sur le premier et le dernier appui pour être rejouée en boucle, puis
+# codée par quartets (4 bits, poids fort d'abord ; décodeur : movements::decodeFrame()).
+# Chaque trame est codée par la variation de son delta avec la trame précédente
+# (dérivée seconde) : la trace est lisse, cette variation est presque toujours petite.
+#   0x0..0xc    trame : variation n - 6 (de -6 à 6)
+#   0xd m       trame : variation 7 + m (de 7 à 22)
+#   0xe m       trame : variation -(7 + m) (de -7 à -22)
+#   0xf 0x0     la trame suivante est un appui
+#   0xf 0x1 h l trame : position absolue (h << 4 | l), le delta devient le saut
+#   0xf 0xf     fin : retour à la première trame (qui est un appui, delta nul)
+# Le dernier octet est complété par un quartet nul.
+import os
+import sys
+
+FRAME_MS = 20
+INPUT = os.path.join("traces", "gait.csv")
+OUTPUT = os.path.join("src", "gaitTrace.h")
+
+SMALL_MAX = 6
+WIDE_MAX = SMALL_MAX + 16
+UP = 0xd
+DOWN = 0xe
+CONTROL = 0xf
+STRIKE = 0x0
+ABSOLUTE = 0x1
+END = 0xf
+
+def read_csv(path):
+    """Retourne les mesures [(temps, position, appui)]."""
+    samples = []
+    with open(path) as f:
+        for line in f:
+            fields = [x.strip() for x in line.split(",")]
+            try:
+                t = float(fields[0])
+                v = float(fields[1])
+            except (ValueError, IndexError):
+                continue
+            strike = None
+            if len(fields) > 2 and fields[2] != "":
+                strike = float(fields[2]) != 0
+            samples.append((t, v, strike))
+    if len(samples) < 2:
+        raise ValueError("%s : pas assez de mesures" % path)
+    return samples
+
+def resample(samples):
+    """Trames de FRAME_MS ms (interpolation linéaire) et appuis (indices des trames)."""
+    t0 = samples[0][0]
+    frames = []
+    strikes = set()
+    k = 0
+    t = t0
+    while t <= samples[-1][0]:
+        while samples[k + 1][0] < t:
+            k += 1
+        (ta, va, _), (tb, vb, _) = samples[k], samples[k + 1]
+        frames.append(va + (vb - va) * (t - ta) / (tb - ta) if tb > ta else va)
+        t += FRAME_MS
+    if any(s[2] is not None for s in samples):
+        for (t, v, strike) in samples:
+            if strike:
+                strikes.add(int(round((t - t0) / FRAME_MS)))
+    return frames, strikes
+
+def normalize(frames):
+    low, high = min(frames), max(frames)
+    if high == low:
+        raise ValueError("trace plate")
+    return [int(round(255 * (v - low) / (high - low))) for v in frames]
+
+def detect_strikes(frames):
+    """Appui : la position repasse sous le quart de la course après avoir dépassé les trois quarts."""
+    strikes = set()
+    armed = False
+    for i, v in enumerate(frames):
+        if v > 192:
+            armed = True
+        elif armed and v < 64:
+            strikes.add(i)
+            armed = False
+    return strikes
+
+def encode(frames, strikes):
+    """Codage des trames 1..n-1 (la trame 0 est donnée par gaitStart) en quartets, puis en octets."""
+    out = []
+    last = 0
+    for i in range(1, len(frames)):
+        if i in strikes:
+            out.extend([CONTROL, STRIKE])
+        d = frames[i] - frames[i - 1]
+        change = d - last
+        if abs(change) <= SMALL_MAX:
+            out.append(change + SMALL_MAX)
+        elif abs(change) <= WIDE_MAX:
+            out.extend([UP if change > 0 else DOWN, abs(change) - SMALL_MAX - 1])
+        else:
+            out.extend([CONTROL, ABSOLUTE, frames[i] >> 4, frames[i] & 0x0f])
+        last = d
+    out.extend([CONTROL, END])
+    if len(out) % 2:
+        out.append(0)
+    return [(out[k] << 4) | out[k + 1] for k in range(0, len(out), 2)]
+
+def convert(source, target):
+    frames, strikes = resample(read_csv(source))
+    frames = normalize(frames)
+    if not strikes:
+        strikes = detect_strikes(frames)
+    strikes = sorted(s for s in strikes if s < len(frames))
+    if len(strikes) < 2:
+        raise ValueError("%s : il faut au moins 2 appuis" % source)
+    # Boucle d'un appui au même appui suivant : la dernière trame est la première de la boucle suivante
+    first, last = strikes[0], strikes[-1]
+    frames = frames[first:last]
+    strikes = set(s - first for s in strikes if first < s < last)
+    steps = len(strikes) + 1
+    data = encode(frames, strikes)
+    frames_by_step = (len(frames) << 16) // steps
+
+    lines = [
+        "// Généré par gaittrace.py depuis %s, ne pas modifier" % source.replace("\\", "/"),
+        "#pragma once",
+        "",
+        "#include <Arduino.h>",
+        "",
+        "/// Recorded gait: %d frames of %d ms (%.1f s), %d steps, %d bytes"
+        % (len(frames), FRAME_MS, len(frames) * FRAME_MS / 1000.0, steps, len(data)),
+        "const unsigned long gaitFrameMs = %d;" % FRAME_MS,
+        "/// Frames by step (16.16)",
+        "const uint32_t gaitFramesPerStep = %dUL;" % frames_by_step,
+        "/// Position of the first frame (a foot strike)",
+        "const uint8_t gaitStart = %d;" % frames[0],
+        "const uint8_t gaitTrace[] PROGMEM = {",
+    ]
+    for i in range(0, len(data), 16):
+        lines.append("  " + ", ".join("0x%02x" % b for b in data[i:i + 16]) + ",")
+    lines.append("};")
+    with open(target, "w") as f:
+        f.write("\n".join(lines) + "\n")
+    print("%s : %d trames, %d pas, %d octets (%.2f octet/trame)"
+          % (target, len(frames), steps, len(data), float(len(data)) / len(frames)))
+
+def outdated(source, target):
+    return (not os.path.exists(target)) or (os.path.getmtime(source) > os.path.getmtime(target))
+
+try:
+    Import("env")
+except NameError:
+    env = None
+
+if env is None:
+    args = sys.argv[1:]
+    convert(args[0] if len(args) > 0 else INPUT, args[1] if len(args) > 1 else OUTPUT)
+else:
+    # Régénération de la table avant le build si la trace a changé
+    source = os.path.join(env.subst("$PROJECT_DIR"), INPUT)
+    target = os.path.join(env.subst("$PROJECT_DIR"), OUTPUT)
+    if os.path.exists(source) and outdated(source, target):
+        convert(source, target)
@@ -13,6 +13,7 @@ Button::Button(unsigned char pin, bool inverted)
     pressedAt = 0;
     releasedAt = 0;
     changedAt = 0;
+    wasReleased = false;
     buttonPressed = false;
     buttonReleased = false;
     oldStatus = false;
@@ -30,7 +31,7 @@ void Button::check()
     {
         btn = !btn;
     }
-    unsigned long now = millis();
+    uint32_t now = millis();
     if ((btn != oldStatus) && ((now - changedAt) > DEBOUNCE_TIME))
     {
         if (btn)
@@ -38,13 +39,14 @@ void Button::check()
             buttonPressed = true;
             buttonReleased = false;
             pressedAt = now;
-            releasedAt = 0;
+            wasReleased = false;
         }
         else
         {
             buttonPressed = false;
             buttonReleased = !isHandled;
             releasedAt = now;
+            wasReleased = true;
             isHandled = false;
         }
         changedAt = now;
@@ -84,12 +86,12 @@ void Button::handled()
 
 unsigned long Button::getPressedDuration()
 {
-    if (releasedAt != 0)
+    if (wasReleased)
     {
         return releasedAt - pressedAt;
     }
     else
     {
-        return millis() - pressedAt;
+        return (uint32_t)millis() - pressedAt;
     }
 }
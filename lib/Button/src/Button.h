@@ -1,14 +1,17 @@
 #ifndef BUTTON_H
 #define BUTTON_H
 
+#include <stdint.h>
+
 #define DEBOUNCE_TIME 5
 
 class Button
 {
 private:
     unsigned char pin_btn;
-    unsigned long changedAt, pressedAt, releasedAt;
+    uint32_t changedAt, pressedAt, releasedAt;  // millis() on 32 bits: only compared through their difference
     bool buttonPressed, buttonReleased;
+    bool wasReleased;
     bool oldStatus, isHandled;
     bool inverted;
 public:
@@ -0,0 +1,227 @@
+#include <Arduino.h>
+#include "Display.h"
+
+// Puissances de 10 de chaque rang, jusqu'aux dizaines de millions (conversion par soustractions : pas de division 32 bits)
+static const unsigned long powersOfTen[DIGIT_MAX + 3] = {1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL, 1000000UL, 10000000UL};
+// Plus grand nombre affiché (en milliers)
+static const unsigned long valueMax = 99999999UL;
+
+// État initial de l'image (les broches sont préparées par Display::begin)
+void DisplayImage::reset()
+{
+  digitNum = 0;
+  blankScreen = false;
+  cursorPos = 0x80;
+  numberDisplayed = false;
+  scale = 0;
+  pointPos = 0x80;
+  dots = 0;
+  brightness = BRIGHTNESS_MAX;
+
+  showScreen = !blankScreen;
+  for (unsigned char p = 0; p < DIGIT_MAX; p++)
+  {
+    shown[p] = 0;
+  }
+  clear();
+}
+
+// Change un chiffre de l'image en cours de composition (marqué modifié seulement s'il change)
+inline void DisplayImage::set(unsigned char pos, unsigned char segs) {
+  if (digits[pos] != segs)
+  {
+    digits[pos] = segs;
+    dirty |= 1 << pos;
+  }
+}
+
+// Met à jour le point du chiffre indiqué. Le point décimal d'un grand nombre
+// est prioritaire : le point d'état de son chiffre réapparaît quand il s'en va.
+void DisplayImage::writeDot(unsigned char digit, bool value) {
+  if (digit < DIGIT_MAX)
+  {
+    dots = value ? (dots | (1 << digit)) : (dots & ~(1 << digit));
+    if (!numberDisplayed || (digit != pointPos))
+    {
+      set(digit, value ? (digits[digit] | 0x01) : (digits[digit] & 0xfe));
+    }
+  }
+}
+
+void DisplayImage::cursor() {
+  cursorPos &= 0x7f;
+}
+
+void DisplayImage::noCursor() {
+  cursorPos |= 0x80;
+}
+
+bool DisplayImage::isCursor() {
+  return !(cursorPos & 0x80);
+}
+
+void DisplayImage::setCursor(unsigned char pos) {
+  cursorPos &= 0x80;
+  cursorPos |= (pos % DIGIT_MAX) & 0x7f;
+}
+
+void DisplayImage::moveCursor(bool left) {
+  cursor();
+  // Retour explicite d'un bout à l'autre : CURSOR_MAX + 1 n'est pas une puissance de 2
+  if (left)
+  {
+    cursorPos = (cursorPos >= CURSOR_MAX) ? 0 : cursorPos + 1;
+  }
+  else
+  {
+    cursorPos = (cursorPos == 0) ? CURSOR_MAX : cursorPos - 1;
+  }
+}
+
+unsigned char DisplayImage::getCursor() {
+  return cursorPos & 0x7f;
+}
+
+// Puissance de 10 du chiffre de droite : 0 jusqu'à 99999, puis 1 à 3 (nombre en milliers)
+unsigned char DisplayImage::getScale() {
+  return scale;
+}
+
+void DisplayImage::clear() {
+  unsigned char p = DIGIT_MAX;
+  do {
+    p--;
+    set(p, 0);
+  } while (p > 0);
+  dots = 0;
+  numberDisplayed = false;
+}
+
+void DisplayImage::lampTest() {
+  unsigned char p = DIGIT_MAX;
+  do {
+    p--;
+    set(p, 0xff);
+  } while (p > 0);
+  numberDisplayed = false;
+}
+
+void DisplayImage::write(unsigned long value) {
+  if (numberDisplayed && (value == valueDisplayed))
+  { // Déjà affiché : rien à recalculer
+    return;
+  }
+  if (!numberDisplayed)
+  { // Les points ont été réécrits depuis le dernier nombre
+    pointPos = 0x80;
+  }
+  valueDisplayed = value;
+  numberDisplayed = true;
+  update();
+}
+
+void DisplayImage::write(unsigned char address, unsigned char value, bool hex) {
+  numberDisplayed = false;
+  unsigned char p = DIGIT_MAX;
+  if (hex)
+  {
+    set(--p, segments[address >> 4]);
+    set(--p, segments[address & 0x0f]);
+  }
+  else
+  {
+    set(--p, segments[(address / 10) % 10]);
+    set(--p, segments[address % 10] | 0x01);
+  }
+  set(--p, segments[(value / 100) % 10]);
+  set(--p, segments[(value / 10) % 10]);
+  set(--p, segments[value % 10]);
+}
+
+void DisplayImage::write(unsigned char pos, unsigned char digit) {
+  pos = pos % DIGIT_MAX;
+  set(pos, digit);
+  numberDisplayed = false;
+}
+
+void DisplayImage::write(unsigned char pos, unsigned char* digit, unsigned char len) {
+  pos = pos % DIGIT_MAX;
+  unsigned char i = 0;
+  while ((i < len) && (pos < DIGIT_MAX))
+  {
+    set(pos++, digit[i++]);
+  }
+  numberDisplayed = false;
+}
+
+// Au-delà de 5 chiffres, le nombre est affiché en milliers avec un point
+// décimal après les milliers : 123.45, 1234.5 puis 12345. Ce point remplace
+// le point d'état de son chiffre.
+void DisplayImage::update() {
+  bool blank = !zeros;
+  unsigned long value = (valueDisplayed > valueMax) ? valueMax : valueDisplayed;
+  scale = 0;
+  while ((scale < 3) && (value >= powersOfTen[DIGIT_MAX + scale]))
+  {
+    scale++;
+  }
+  pointPos = (scale > 0) ? 3 - scale : 0x80;
+  unsigned char p = DIGIT_MAX;
+  do {
+    p--;
+    unsigned char segs = (p == pointPos) ? 0x01 : ((dots >> p) & 0x01);
+    // Chiffre de rang p + scale (les rangs plus bas ne sont pas affichés)
+    unsigned char digit = 0;
+    while (value >= powersOfTen[p + scale])
+    {
+      value -= powersOfTen[p + scale];
+      digit++;
+    }
+    if ((digit > 0) || (p == 0))
+    {
+      blank = false;
+    }
+    if (!blank)
+    {
+      segs |= segments[digit];
+    }
+    set(p, segs);
+  } while (p > 0);
+}
+
+void DisplayImage::leadingZeros() {
+  zeros = true;
+  if (numberDisplayed)
+  {
+    update();
+  }
+}
+
+void DisplayImage::noLeadingZeros() {
+  zeros = false;
+  if (numberDisplayed)
+  {
+    update();
+  }
+}
+
+void DisplayImage::display() {
+  blankScreen = false;
+}
+
+void DisplayImage::noDisplay() {
+  blankScreen = true;
+}
+
+bool DisplayImage::isDisplay() {
+  return showScreen;
+}
+
+// Luminosité de 0 (éteint) à BRIGHTNESS_MAX (chaque chiffre allumé tout son temps)
+void DisplayImage::setBrightness(unsigned char level) {
+  brightness = (level > BRIGHTNESS_MAX) ? BRIGHTNESS_MAX : level;
+}
+
+unsigned char DisplayImage::getBrightness() {
+  return brightness;
+}
@@ -0,0 +1,241 @@
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include <Arduino.h>
+
+#define DIGIT_MAX               5
+#define CURSOR_MAX              4
+#define CURSOR_BLINK_PERIOD   400
+#define DIGIT_TIME           2000   // Durée d'affichage de chaque chiffre (µs)
+#define BRIGHTNESS_MAX         16
+
+/*
+ * Image de l'afficheur : chiffres, curseur, points et luminosité.
+ * Ne dépend pas du câblage (voir Display, qui l'envoie sur les broches).
+ */
+class DisplayImage
+{
+
+/*
+ * Tables de caractères
+ * Les segments sont dans l'ordre classiques: a b c d e f g dp
+ * Caractères disponibles: 0 1 2 3 4 5 6 7 8 9 A B C D E F
+ */
+const unsigned char segments[17] = {
+  0xfc, // 0: b11111100
+  0x60, // 1: b01100000
+  0xda, // 2: b11011010
+  0xf2, // 3: b11110010
+  0x66, // 4: b01100110
+  0xb6, // 5: b10110110
+  0xbe, // 6: b10111110
+  0xe0, // 7: b11100000
+  0xfe, // 8: b11111110
+  0xf6, // 9: b11110110
+  0xee, // A: b11101110
+  0x3e, // b: b00111110
+  0x1a, // c: b00011010
+  0x7a, // d: b01111010
+  0x9e, // E: b10011110
+  0x8e, // F: b10001110
+  0x02  // -: b00000010
+};
+
+protected:
+    unsigned char digits[DIGIT_MAX];  // Image en cours de composition, écrite par les fonctions d'affichage
+    unsigned char shown[DIGIT_MAX];   // Image multiplexée, recopiée de digits au début de chaque cycle
+    unsigned char dirty;              // Chiffres de digits modifiés depuis la dernière recopie (bit 0 : chiffre 0)
+    unsigned char digitNum;
+    bool showScreen, blankScreen;
+    unsigned char cursorPos;          // Position du curseur. Si le bit 7 est à 1, il n'est pas affiché.
+    unsigned char brightness;         // Part du temps où chaque chiffre est allumé (en 1/BRIGHTNESS_MAX)
+    void reset();
+
+private:
+    unsigned long valueDisplayed;
+    unsigned char scale;              // Puissance de 10 du chiffre de droite (0 : unités, 3 : milliers)
+    unsigned char pointPos;           // Position du point décimal des grands nombres (0x80 : aucun)
+    unsigned char dots;               // Points d'état demandés par writeDot (bit 0 : chiffre 0)
+    void update();
+    void set(unsigned char pos, unsigned char segs);
+    bool zeros;
+    bool numberDisplayed;
+
+public:
+    void cursor();
+    void noCursor();
+    bool isCursor();
+    unsigned char getCursor();
+    unsigned char getScale();
+    void setCursor(unsigned char pos);
+    void moveCursor(bool left);
+    void write(unsigned long value);
+    void write(unsigned char address, unsigned char value, bool hex);
+    void write(unsigned char pos, unsigned char digit);
+    void write(unsigned char pos, unsigned char* digit, unsigned char len);
+    void writeDot(unsigned char digit, bool value);
+    void clear();
+    void lampTest();
+    void leadingZeros();
+    void noLeadingZeros();
+    void display();
+    void noDisplay();
+    bool isDisplay();
+    void setBrightness(unsigned char level);
+    unsigned char getBrightness();
+};
+
+/*
+ * Afficheur câblé sur des broches connues à la compilation. Pins donne les broches :
+ *   struct Pins { static constexpr unsigned char clock, data, strobe, reset, enable; };
+ * Sur l'Uno, chaque écriture est une seule instruction sur le port (sbi/cbi) au lieu
+ * d'un appel à digitalWrite ; ailleurs (simulation sur PC), digitalWrite est gardé.
+ */
+template <class Pins>
+class Display : public DisplayImage
+{
+private:
+    template <unsigned char pin>
+    static void out(bool level);
+
+public:
+    ~Display();
+    void begin();
+    void displayNextDigit();
+};
+
+template <class Pins>
+template <unsigned char pin>
+inline void Display<Pins>::out(bool level) {
+#if defined(__AVR_ATmega328P__)
+  static_assert(pin < 20, "Broche inconnue de l'ATmega328P");
+  // Broches 0 à 7 : PORTD, 8 à 13 : PORTB, 14 à 19 (A0 à A5) : PORTC
+  volatile uint8_t &port = (pin < 8) ? PORTD : ((pin < 14) ? PORTB : PORTC);
+  const uint8_t mask = 1 << ((pin < 8) ? pin : ((pin < 14) ? pin - 8 : pin - 14));
+  if (level)
+  {
+    port |= mask;
+  }
+  else
+  {
+    port &= ~mask;
+  }
+#else
+  digitalWrite(pin, level);
+#endif
+}
+
+template <class Pins>
+Display<Pins>::~Display()
+{
+  clear();
+  out<Pins::reset>(LOW);
+  out<Pins::clock>(LOW);
+  out<Pins::data>(LOW);
+  out<Pins::strobe>(LOW);
+  out<Pins::enable>(LOW);
+  pinMode(Pins::clock, INPUT);
+  pinMode(Pins::data, INPUT);
+  pinMode(Pins::strobe, INPUT);
+  pinMode(Pins::reset, INPUT);
+  pinMode(Pins::enable, INPUT);
+}
+
+template <class Pins>
+void Display<Pins>::begin()
+{
+  reset();
+  pinMode(Pins::clock, OUTPUT);
+  pinMode(Pins::data, OUTPUT);
+  pinMode(Pins::strobe, OUTPUT);
+  pinMode(Pins::reset, OUTPUT);
+  pinMode(Pins::enable, OUTPUT);
+  out<Pins::clock>(LOW);
+  out<Pins::data>(LOW);
+  out<Pins::strobe>(LOW);
+  out<Pins::enable>(LOW);
+  out<Pins::reset>(HIGH);
+}
+
+// Affiche le chiffre suivant en utilisant du multiplexage
+template <class Pins>
+void Display<Pins>::displayNextDigit() {
+  unsigned char digit;
+  bool cursorBlinkOn = (millis() % CURSOR_BLINK_PERIOD) < (CURSOR_BLINK_PERIOD / 2);
+  bool isDigit0 = (digitNum == 0);
+
+  if (isDigit0 && dirty)
+  { // Début d'un cycle : recopie des chiffres modifiés, jamais d'image à moitié écrite
+    for (unsigned char p = 0; p < DIGIT_MAX; p++)
+    {
+      if (dirty & (1 << p))
+      {
+        shown[p] = digits[p];
+      }
+    }
+    dirty = 0;
+  }
+  if (isDigit0 && (showScreen == blankScreen))
+  {
+    if (blankScreen)
+    {
+      out<Pins::enable>(LOW);
+      out<Pins::reset>(HIGH);
+      for(int i=0; i<8; i++)
+      {
+        out<Pins::data>(LOW);
+        out<Pins::clock>(HIGH);
+        out<Pins::clock>(LOW);
+      }
+      out<Pins::strobe>(HIGH);
+      out<Pins::strobe>(LOW);
+      out<Pins::reset>(LOW);
+      showScreen = false;
+    }
+    else
+    {
+      showScreen = true;
+    }
+  }
+  if (showScreen)
+  {
+    // Switch off the current digit
+    out<Pins::enable>(LOW);
+    out<Pins::reset>(isDigit0);
+    if (cursorBlinkOn && (cursorPos == digitNum))
+    { // Cursor visible
+      digit = (shown[digitNum] & 0x01) | 0x10;
+    }
+    else
+    {
+      digit = shown[digitNum];
+    }
+    // Send all segments serially
+    for(int i=0; i<8; i++)
+    {
+      out<Pins::data>(bitRead(digit, i));
+      out<Pins::clock>(HIGH);
+      out<Pins::clock>(LOW);
+    }
+    // Strobe the shift register
+    out<Pins::strobe>(HIGH);
+    out<Pins::strobe>(LOW);
+    // Switch on the current digit if activated
+    out<Pins::enable>(showScreen);
+    if (brightness < BRIGHTNESS_MAX)
+    { // Only a part of the time of the digit (enable is on timer1, used by the servo: no hardware PWM)
+      unsigned int on = brightness * (DIGIT_TIME / BRIGHTNESS_MAX);
+      delayMicroseconds(on);
+      out<Pins::enable>(LOW);
+      delayMicroseconds(DIGIT_TIME - on);
+    }
+    else
+    { // The digit stays on up to the next one
+      delay(DIGIT_TIME / 1000);
+    }
+    digitNum++;
+    digitNum %= DIGIT_MAX;
+  }
+}
+
+#endif
@@ -0,0 +1,92 @@
+#pragma once
+
+// Host replacement of the Arduino core (see sim.h)
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include "avr/interrupt.h"
+
+typedef uint8_t byte;
+
+#define HIGH          1
+#define LOW           0
+#define INPUT         0
+#define OUTPUT        1
+#define INPUT_PULLUP  2
+#define CHANGE        1
+#define FALLING       2
+#define RISING        3
+#define DEFAULT       1
+#define INTERNAL      3
+#define LED_BUILTIN   13
+#define A0            14
+#define A1            15
+#define NUM_DIGITAL_PINS 20
+#define INT0          0
+#define INT1          1
+#define BODS          6
+#define BODSE         5
+#define REFS1         7
+#define REFS0         6
+#define ADEN          7
+#define ADSC          6
+#define ADATE         5
+#define ADIF          4
+#define ADIE          3
+#define ADPS2         2
+#define ADPS1         1
+#define ADPS0         0
+#define ADTS2         2
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define bit(b) (1UL << (b))
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define digitalPinToInterrupt(p) ((p) == 2 ? 0 : ((p) == 3 ? 1 : -1))
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define memcpy_P(dest, src, n) memcpy((dest), (src), (n))
+
+// Registers touched directly by the firmware
+extern volatile uint8_t ADCSRA, ADCSRB, ADMUX, DIDR0, MCUCR, EIFR;
+extern volatile uint16_t ADC;
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void analogReference(uint8_t mode);
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void attachInterrupt(uint8_t interrupt, void (*isr)(void), int mode);
+void detachInterrupt(uint8_t interrupt);
+void noInterrupts();
+void interrupts();
+
+/// Serial port: received bytes are fed by sim::serialInput(), sent bytes are kept by the simulator
+class HardwareSerial
+{
+public:
+    void begin(unsigned long baud);
+    int available();
+    int read();
+    size_t write(uint8_t c);
+    size_t print(const char *s);
+    size_t print(char c);
+    size_t print(int n);
+    size_t print(unsigned int n);
+    size_t print(long n);
+    size_t print(unsigned long n);
+    size_t println();
+    size_t println(const char *s);
+    size_t println(int n);
+    size_t println(unsigned int n);
+    size_t println(long n);
+    size_t println(unsigned long n);
+};
+
+extern HardwareSerial Serial;
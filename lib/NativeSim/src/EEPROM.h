@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include "sim.h"
+
+/// Host replacement of the EEPROM library, backed by sim::eeprom
+struct EEPROMClass
+{
+    uint8_t read(int address) { return sim::eeprom[address % sim::eepromSize]; }
+    void write(int address, uint8_t value) { sim::eeprom[address % sim::eepromSize] = value; }
+    void update(int address, uint8_t value) { write(address, value); }
+    uint16_t length() { return sim::eepromSize; }
+    template <typename T> T &get(int address, T &t)
+    {
+        memcpy(&t, sim::eeprom + address, sizeof(T));
+        return t;
+    }
+    template <typename T> const T &put(int address, const T &t)
+    {
+        memcpy(sim::eeprom + address, &t, sizeof(T));
+        return t;
+    }
+};
+
+extern EEPROMClass EEPROM;
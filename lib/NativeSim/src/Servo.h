@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdint.h>
+
+/// Host replacement of the Servo library: positions are recorded by the simulator
+class Servo
+{
+private:
+    bool isAttached;
+    int position;
+public:
+    Servo();
+    uint8_t attach(int pin);
+    void detach();
+    bool attached();
+    void write(int value);
+    int read();
+};
@@ -0,0 +1,5 @@
+#pragma once
+
+// Host replacement: an interrupt handler is a plain function, called by the simulator
+
+#define ISR(vector) extern "C" void vector(void)
@@ -0,0 +1,6 @@
+#pragma once
+
+// Host replacement: nothing to power
+
+void power_all_disable();
+void power_all_enable();
@@ -0,0 +1,11 @@
+#pragma once
+
+// Host replacement: sleeping returns immediately
+
+#define SLEEP_MODE_IDLE       0
+#define SLEEP_MODE_PWR_DOWN   2
+
+void set_sleep_mode(int mode);
+void sleep_enable();
+void sleep_disable();
+void sleep_cpu();
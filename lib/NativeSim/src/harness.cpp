@@ -0,0 +1,246 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "Arduino.h"
+#include "harness.h"
+
+// Firmware entry points
+void setup();
+void loop();
+
+namespace harness
+{
+void runUntil(uint64_t end)
+{
+    while (sim::now() < end)
+    {
+        uint64_t before = sim::now();
+        loop();
+        if (sim::now() == before)
+        { // Nothing waited: the main loop takes at least some time
+            sim::advanceMicros(100);
+        }
+    }
+}
+
+void run(unsigned long ms)
+{
+    runUntil(sim::now() + (uint64_t)ms * 1000);
+}
+
+std::string command(const char *cmd)
+{
+    sim::serialOutput();
+    sim::serialInput(cmd);
+    sim::serialInput("\n");
+    run(5);
+    return sim::serialOutput();
+}
+
+void boot(uint8_t syncMode, long driftPpm)
+{
+    memset(sim::eeprom, 0xff, sim::eepromSize);
+    sim::setClockDrift(driftPpm);
+    powerUp();
+    if (syncMode != 0)
+    {
+        char cmd[16];
+        snprintf(cmd, sizeof(cmd), "W %u %u", syncModeAddress, syncMode);
+        command(cmd);
+    }
+}
+
+void powerUp()
+{
+    setup();
+    run(100);
+}
+
+void loadProgram(const char *hex)
+{
+    char cmd[64];
+    size_t len = strlen(hex);
+    for (size_t offset = 0; offset < len; offset += 32)
+    {
+        snprintf(cmd, sizeof(cmd), "M %zu %.32s", offset / 2, hex + offset);
+        if (command(cmd).compare(0, 2, "OK") != 0)
+        {
+            fprintf(stderr, "Program refused: %s\n", cmd);
+            exit(1);
+        }
+    }
+    if (command("L 1").compare(0, 2, "OK") != 0)
+    {
+        fprintf(stderr, "Program not selectable\n");
+        exit(1);
+    }
+}
+
+unsigned long session(unsigned long steps, unsigned long speed, int *state)
+{
+    char cmd[32];
+    if (steps == 0)
+    {
+        command("G");
+        do
+        {
+            run(1000);
+            std::string status = command("?");
+            sscanf(status.c_str(), "OK %d", state);
+        } while (*state != 6);
+        return 0;
+    }
+    snprintf(cmd, sizeof(cmd), "S %lu", steps);
+    if (command(cmd).compare(0, 2, "OK") != 0)
+    {
+        fprintf(stderr, "Steps refused: %lu\n", steps);
+        exit(1);
+    }
+    snprintf(cmd, sizeof(cmd), "V %lu", speed);
+    if (command(cmd).compare(0, 2, "OK") != 0)
+    {
+        fprintf(stderr, "Speed refused: %lu\n", speed);
+        exit(1);
+    }
+    uint64_t startedAt = sim::now();
+    command("G");
+
+    // Expected duration + 10%
+    uint64_t timeoutUs = (uint64_t)steps * 66000000ULL / speed;
+    unsigned long remaining = steps;
+    do
+    {
+        run(1000);
+        std::string status = command("?");
+        // A master also sends its own commands on the serial port
+        size_t ok = status.rfind("OK ");
+        if ((ok == std::string::npos) || (sscanf(status.c_str() + ok, "OK %d %lu", state, &remaining) != 2))
+        {
+            fprintf(stderr, "Bad status: %s\n", status.c_str());
+            exit(1);
+        }
+    } while ((remaining > 0) && (sim::now() - startedAt < timeoutUs));
+    return remaining;
+}
+
+int status()
+{
+    int state = 0;
+    std::string s = command("?");
+    size_t ok = s.rfind("OK ");
+    if ((ok == std::string::npos) || (sscanf(s.c_str() + ok, "OK %d", &state) != 1))
+    {
+        fprintf(stderr, "Bad status: %s\n", s.c_str());
+        exit(1);
+    }
+    return state;
+}
+
+unsigned long remainingSteps(int *state)
+{
+    unsigned long remaining = 0;
+    std::string s = command("?");
+    size_t ok = s.rfind("OK ");
+    if ((ok == std::string::npos) || (sscanf(s.c_str() + ok, "OK %d %lu", state, &remaining) != 2))
+    {
+        fprintf(stderr, "Bad status: %s\n", s.c_str());
+        exit(1);
+    }
+    return remaining;
+}
+
+void resume()
+{
+    command("X");
+    if (status() == -1)
+    {
+        click();
+    }
+}
+
+void click()
+{
+    sim::pressButton();
+    run(50);
+    sim::releaseButton();
+    run(50);
+}
+
+double downsSpan(size_t first)
+{
+    const std::vector<uint64_t> &downs = sim::footDowns();
+    return (downs.size() > first + 1) ? (double)(downs.back() - downs[first]) / 1000.0 : 0.0;
+}
+
+bool appendTrace(const std::string &answers, std::vector<uint8_t> *bytes)
+{
+    bool more = false;
+    size_t ok = 0;
+    while ((ok = answers.find("OK", ok)) != std::string::npos)
+    {
+        ok += 2;
+        while ((ok < answers.size()) && (answers[ok] == ' '))
+        {
+            ok++;
+        }
+        while ((ok + 1 < answers.size()) && isxdigit(answers[ok]) && isxdigit(answers[ok + 1]))
+        {
+            bytes->push_back((uint8_t)strtoul(answers.substr(ok, 2).c_str(), nullptr, 16));
+            ok += 2;
+            more = true;
+        }
+    }
+    return more;
+}
+
+std::vector<InputEvent> decodeTrace(const std::vector<uint8_t> &bytes)
+{
+    std::vector<InputEvent> events;
+    uint64_t at = 0;
+    size_t k = 0;
+    while (k < bytes.size())
+    {
+        uint8_t code = bytes[k++];
+        uint64_t delta = 0;
+        int shift = 0;
+        while ((k < bytes.size()) && (bytes[k] & 0x80))
+        {
+            delta |= (uint64_t)(bytes[k++] & 0x7f) << shift;
+            shift += 7;
+        }
+        if (k == bytes.size())
+        { // Truncated
+            break;
+        }
+        delta |= (uint64_t)bytes[k++] << shift;
+        at += delta;
+        events.push_back({at, code});
+    }
+    return events;
+}
+
+unsigned int scheduleInputs(const std::vector<InputEvent> &events)
+{
+    unsigned int lost = 0;
+    for (const InputEvent &e : events)
+    {
+        uint64_t at = e.at * 1000;
+        switch (e.code & 0xc0)
+        {
+            case 0x00: // Button
+                sim::schedulePin(at, pinButton, (e.code & 1) ? LOW : HIGH);
+                break;
+            case 0x40: // Encoder: direction read on B when A falls
+                sim::schedulePin(at, pinEncoderB, (e.code & 1) ? LOW : HIGH);
+                sim::schedulePin(at, pinEncoderA, LOW);
+                sim::schedulePin(at, pinEncoderA, HIGH);
+                sim::schedulePin(at, pinEncoderB, HIGH);
+                break;
+            case 0xc0:
+                lost++;
+                break;
+        }
+    }
+    return lost;
+}
+} // namespace harness
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "board.h"
+#include "configLayout.h"
+#include "sim.h"
+
+/// Driving the firmware on the host: power up, main loop, serial commands.
+/// Shared by the simulator (simulator.cpp) and the unit tests (test/).
+/// The config layout and the pins come from the firmware (configLayout.h, board.h).
+namespace harness
+{
+/// EEPROM address of the config version, and the version of the layout
+const uint16_t versionAddress = registers::versionAddress;
+const uint8_t configVersion = registers::configVersion;
+/// Address of sync_mode in the config
+const uint8_t syncModeAddress = offsetof(MyConfig_t, sync_mode);
+/// Address of servo_settle in the config
+const uint8_t servoSettleAddress = offsetof(MyConfig_t, servo_settle);
+/// Address of var_jitter in the config (then var_drift and var_fatigue)
+const uint8_t cadenceAddress = offsetof(MyConfig_t, var_jitter);
+/// Address of gait_replay in the config
+const uint8_t gaitReplayAddress = offsetof(MyConfig_t, gait_replay);
+/// Address of batt_low in the config (then batt_off)
+const uint8_t batteryAddress = offsetof(MyConfig_t, batt_low);
+/// Address of disp_bright in the config (then disp_dim)
+const uint8_t displayAddress = offsetof(MyConfig_t, disp_bright);
+/// Pin enabling the digits of the display
+const uint8_t pinDigitEnable = board::pinDigitEna;
+/// Pin of the encoder button (INT0, active low)
+const uint8_t pinButton = board::pinEncS;
+/// Pin of the buzzer
+const uint8_t pinBuzzer = board::pinBuzzer;
+/// Pins of the encoder (A on INT1, B read when A falls)
+const uint8_t pinEncoderA = board::pinEncA;
+const uint8_t pinEncoderB = board::pinEncB;
+
+/// Run the firmware main loop until a virtual time
+void runUntil(uint64_t end);
+/// Run the firmware main loop for some virtual time
+void run(unsigned long ms);
+/// Send a command and return the answer
+std::string command(const char *cmd);
+/// Power up a board on an erased EEPROM (the firmware writes its default config), then set its sync mode
+void boot(uint8_t syncMode, long driftPpm);
+/// Power up the board on its EEPROM as it is
+void powerUp();
+/// Upload a program (hexadecimal) and select it
+void loadProgram(const char *hex);
+/// Run a whole session driven by serial commands. Returns the number of steps remaining.
+/// With steps = 0, runs the selected program up to its end.
+unsigned long session(unsigned long steps, unsigned long speed, int *state);
+/// State of the firmware (from the status command)
+int status();
+/// Steps remaining and state (from the status command)
+unsigned long remainingSteps(int *state);
+/// Bring the board back to SetSteps (after a jump of the clock, it may be powered off)
+void resume();
+/// Short click of the button
+void click();
+/// Time between the first and the last foot down since `first` (ms)
+double downsSpan(size_t first);
+
+/// Event of an input trace (see inputTraceHelper.h)
+struct InputEvent
+{
+    uint64_t at;    // Board time (ms)
+    uint8_t code;   // Type and value
+};
+/// Append the bytes of the answers of J (hexadecimal after OK) to a trace. Returns false on an empty answer.
+bool appendTrace(const std::string &answers, std::vector<uint8_t> *bytes);
+/// Decode a trace into events
+std::vector<InputEvent> decodeTrace(const std::vector<uint8_t> &bytes);
+/// Drive the edges of the button and the encoder of a trace at their time (from power up at time 0).
+/// Returns the number of Lost events.
+unsigned int scheduleInputs(const std::vector<InputEvent> &events);
+} // namespace harness
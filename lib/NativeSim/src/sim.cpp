@@ -0,0 +1,642 @@
+#include <stddef.h>
+#include <stdio.h>
+#include <deque>
+#include <map>
+#include "Arduino.h"
+#include "Servo.h"
+#include "EEPROM.h"
+#include "avr/sleep.h"
+#include "avr/power.h"
+#include "configLayout.h"
+#include "sim.h"
+
+volatile uint8_t ADCSRA, ADCSRB, ADMUX, DIDR0, MCUCR, EIFR;
+volatile uint16_t ADC;
+HardwareSerial Serial;
+
+// ADC interrupt handler of the firmware, if any
+extern "C" void ADC_vect(void) __attribute__((weak));
+EEPROMClass EEPROM;
+
+namespace sim
+{
+uint8_t eeprom[eepromSize];
+
+namespace
+{
+uint64_t clockUs = 0;
+long driftPpm = 0;
+// Encoder and button pins have pull-ups
+uint8_t pins[NUM_DIGITAL_PINS] = {0, 0, HIGH, HIGH, HIGH};
+// Time each pin went high, and total time high before
+uint64_t highSince[NUM_DIGITAL_PINS];
+uint64_t highUs[NUM_DIGITAL_PINS];
+void (*isrs[2])(void) = {nullptr, nullptr};
+int isrModes[2];
+bool interruptsEnabled = true;
+std::deque<char> rx;
+std::string tx;
+bool echo = false;
+ServoRecord servoRecord = {0, 0, 0, 0};
+uint64_t servoAttachedAt = 0;
+bool servoAttached = false;
+std::vector<uint64_t> downs;
+std::vector<SerialByte> trace;
+// Duration of a byte at 9600 bauds (10 bits)
+const uint64_t byteUs = 1042;
+
+// Timer0 overflow (ADC auto trigger): every 1024 us at 16 MHz
+const uint64_t timer0Us = 1024;
+// Longest catch up of ADC conversions after a jump of the clock
+const uint64_t adcCatchUpUs = 1000000;
+uint64_t nextConversionAt = timer0Us;
+// Battery: voltage with new batteries, drain by servo position and by second attached (uV)
+unsigned long batteryMv = 0;
+unsigned long batteryByMove = 0;
+unsigned long batteryBySecond = 0;
+ServoRecord batteryFrom = {0, 0, 0, 0};
+uint32_t noise = 1;
+
+// Input edges to come: pin and level by time (us)
+std::multimap<uint64_t, std::pair<uint8_t, uint8_t>> scheduled;
+
+const uint8_t pinButton = 2;
+const uint8_t pinEncoderA = 3;
+const uint8_t pinEncoderB = 4;
+
+// Display: shift register of the segments (data, clock, strobe) and counter of the digit (reset)
+const uint8_t pinSrDi = 5;
+const uint8_t pinSrCk = 6;
+const uint8_t pinSrSt = 7;
+const uint8_t pinCounterReset = 8;
+bool displayFollowed = false;
+uint8_t shiftRegister = 0;
+uint8_t digitCounter = 0;
+uint8_t latched[displayDigits];
+} // namespace
+
+uint64_t now()
+{
+    return clockUs;
+}
+
+/// Run the ADC conversions triggered since the last call (auto trigger on timer0 overflow)
+void convert()
+{
+    if (nextConversionAt + adcCatchUpUs < clockUs)
+    {
+        nextConversionAt = clockUs - adcCatchUpUs;
+    }
+    const uint8_t running = bit(ADEN) | bit(ADATE) | bit(ADIE);
+    while (nextConversionAt <= clockUs)
+    {
+        nextConversionAt += timer0Us;
+        if (((ADCSRA & running) == running) && interruptsEnabled && (ADC_vect != nullptr))
+        {
+            // +/-2 LSB of noise
+            noise = noise * 1103515245UL + 12345UL;
+            long value = (long)((uint64_t)batteryMillivolts() * 1024 / batteryFullScaleMv) + (long)((noise >> 16) % 5) - 2;
+            ADC = (uint16_t)constrain(value, 0L, 1023L);
+            ADC_vect();
+        }
+    }
+}
+
+/// Move the clock forward, driving the scheduled inputs on the way
+void moveClock(uint64_t to)
+{
+    while (!scheduled.empty() && (scheduled.begin()->first <= to))
+    {
+        std::multimap<uint64_t, std::pair<uint8_t, uint8_t>>::iterator edge = scheduled.begin();
+        clockUs = (edge->first > clockUs) ? edge->first : clockUs;
+        uint8_t pin = edge->second.first;
+        uint8_t value = edge->second.second;
+        scheduled.erase(edge);
+        setPin(pin, value);
+    }
+    clockUs = (to > clockUs) ? to : clockUs;
+}
+
+void advance(unsigned long ms)
+{
+    moveClock(clockUs + (uint64_t)ms * 1000);
+    convert();
+}
+
+void advanceMicros(unsigned long us)
+{
+    moveClock(clockUs + us);
+    convert();
+}
+
+void setClockDrift(long ppm)
+{
+    driftPpm = ppm;
+}
+
+/// Time as seen by the board (with its drift)
+uint64_t localMicros()
+{
+    if (driftPpm == 0)
+    {
+        return clockUs;
+    }
+    return clockUs + (uint64_t)((int64_t)(clockUs / 1000000) * driftPpm)
+        + (uint64_t)((int64_t)(clockUs % 1000000) * driftPpm / 1000000);
+}
+
+/// Advance the time as seen by the board
+void localAdvanceMicros(uint64_t us)
+{
+    moveClock(clockUs + ((driftPpm == 0) ? us : us * 1000000 / (uint64_t)(1000000 + driftPpm)));
+    convert();
+}
+
+uint64_t boardMillis()
+{
+    return localMicros() / 1000;
+}
+
+void advanceToBoardMillis(uint64_t ms)
+{
+    if (ms * 1000 > localMicros())
+    {
+        localAdvanceMicros(ms * 1000 - localMicros());
+    }
+}
+
+void setBattery(unsigned long mv, unsigned long uvByMove, unsigned long uvBySecond)
+{
+    batteryMv = mv;
+    batteryByMove = uvByMove;
+    batteryBySecond = uvBySecond;
+    batteryFrom = servo();
+}
+
+unsigned long batteryMillivolts()
+{
+    if (batteryMv == 0)
+    {
+        return 0;
+    }
+    ServoRecord s = servo();
+    uint64_t drain = (uint64_t)(s.writes - batteryFrom.writes) * batteryByMove
+        + (s.attachedUs - batteryFrom.attachedUs) * batteryBySecond / 1000000;
+    drain /= 1000;
+    return (drain >= batteryMv) ? 0 : batteryMv - (unsigned long)drain;
+}
+
+/// Follow the display on the rising edges of its pins: each strobe latches the segments of the next digit
+void displayRising(uint8_t pin)
+{
+    if (pin == pinSrCk)
+    { // Bit 0 of the segments is sent first
+        shiftRegister = (shiftRegister >> 1) | (pins[pinSrDi] ? 0x80 : 0);
+    }
+    else if (pin == pinSrSt)
+    {
+        if (!pins[pinCounterReset])
+        {
+            digitCounter++;
+        }
+        if (digitCounter < displayDigits)
+        {
+            latched[digitCounter] = shiftRegister;
+        }
+    }
+    else if (pin == pinCounterReset)
+    {
+        digitCounter = 0;
+    }
+}
+
+/// Change the level of a pin
+void writePin(uint8_t pin, uint8_t value)
+{
+    if (value && !pins[pin])
+    {
+        highSince[pin] = clockUs;
+    }
+    else if (!value && pins[pin])
+    {
+        highUs[pin] += clockUs - highSince[pin];
+    }
+    pins[pin] = value;
+}
+
+void followDisplay(bool follow)
+{
+    displayFollowed = follow;
+}
+
+std::string displayText()
+{
+    // Segments a to g (bits 7 to 1) of the digits 0 to 9
+    static const uint8_t figures[10] = {0xfc, 0x60, 0xda, 0xf2, 0x66, 0xb6, 0xbe, 0xe0, 0xfe, 0xf6};
+    std::string text;
+    for (int p = displayDigits - 1; p >= 0; p--)
+    {
+        uint8_t segs = latched[p] & 0xfe;
+        char c = (segs == 0) ? ' ' : (segs == 0x02) ? '-' : '?';
+        for (uint8_t f = 0; f < 10; f++)
+        {
+            c = (segs == figures[f]) ? (char)('0' + f) : c;
+        }
+        text += c;
+        if (latched[p] & 0x01)
+        {
+            text += '.';
+        }
+    }
+    return text;
+}
+
+void schedulePin(uint64_t at, uint8_t pin, uint8_t value)
+{
+    scheduled.insert(std::make_pair(at, std::make_pair(pin, value)));
+}
+
+void setPin(uint8_t pin, uint8_t value)
+{
+    uint8_t old = pins[pin];
+    writePin(pin, value ? HIGH : LOW);
+    int interrupt = digitalPinToInterrupt(pin);
+    if ((interrupt >= 0) && interruptsEnabled && (isrs[interrupt] != nullptr) && (old != pins[pin]))
+    {
+        int mode = isrModes[interrupt];
+        if ((mode == CHANGE) || ((mode == FALLING) && !pins[pin]) || ((mode == RISING) && pins[pin]))
+        {
+            isrs[interrupt]();
+        }
+    }
+}
+
+uint8_t getPin(uint8_t pin)
+{
+    return pins[pin];
+}
+
+uint64_t pinHighMicros(uint8_t pin)
+{
+    return highUs[pin] + (pins[pin] ? clockUs - highSince[pin] : 0);
+}
+
+void pressButton()
+{
+    setPin(pinButton, LOW);
+}
+
+void releaseButton()
+{
+    setPin(pinButton, HIGH);
+}
+
+void turnEncoder(int detents, unsigned long intervalMs)
+{
+    while (detents != 0)
+    {
+        // Direction is read on B when A falls
+        setPin(pinEncoderB, detents < 0);
+        setPin(pinEncoderA, LOW);
+        advance(intervalMs / 2);
+        setPin(pinEncoderA, HIGH);
+        advance(intervalMs - intervalMs / 2);
+        detents += (detents < 0) ? 1 : -1;
+    }
+    setPin(pinEncoderB, HIGH);
+}
+
+ServoRecord servo()
+{
+    ServoRecord r = servoRecord;
+    if (servoAttached)
+    {
+        r.attachedUs += clockUs - servoAttachedAt;
+    }
+    return r;
+}
+
+const std::vector<uint64_t> &footDowns()
+{
+    return downs;
+}
+
+void servoWrite(int position, bool attached)
+{
+    servoRecord.position = position;
+    if (attached)
+    {
+        servoRecord.writes++;
+        if (position == eeprom[offsetof(MyConfig_t, pos_stepdown)])
+        {
+            downs.push_back(clockUs);
+        }
+    }
+}
+
+void servoAttach(bool attached)
+{
+    if (attached && !servoAttached)
+    {
+        servoRecord.attaches++;
+        servoAttachedAt = clockUs;
+    }
+    else if (!attached && servoAttached)
+    {
+        servoRecord.attachedUs += clockUs - servoAttachedAt;
+    }
+    servoAttached = attached;
+}
+
+void serialInput(const char *text)
+{
+    while (*text)
+    {
+        rx.push_back(*text++);
+    }
+}
+
+std::string serialOutput()
+{
+    std::string out;
+    out.swap(tx);
+    return out;
+}
+
+void serialEcho(bool enable)
+{
+    echo = enable;
+}
+
+const std::vector<SerialByte> &serialTrace()
+{
+    return trace;
+}
+
+void serialSend(char c)
+{
+    uint64_t at = (trace.empty() || (trace.back().at < clockUs)) ? clockUs : trace.back().at;
+    trace.push_back({at + byteUs, c});
+    tx.push_back(c);
+    if (echo)
+    {
+        putchar(c);
+    }
+}
+
+int serialAvailable()
+{
+    return (int)rx.size();
+}
+
+int serialRead()
+{
+    if (rx.empty())
+    {
+        return -1;
+    }
+    char c = rx.front();
+    rx.pop_front();
+    return (unsigned char)c;
+}
+
+void attach(uint8_t interrupt, void (*isr)(void), int mode)
+{
+    isrs[interrupt] = isr;
+    isrModes[interrupt] = mode;
+}
+
+void enableInterrupts(bool enable)
+{
+    interruptsEnabled = enable;
+}
+} // namespace sim
+
+/*
+ * Arduino core ***************************************************************
+ */
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    if (mode == INPUT_PULLUP)
+    {
+        sim::pins[pin] = HIGH;
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    value = value ? HIGH : LOW;
+    if (value == sim::pins[pin])
+    { // Most writes of the display do not change the level
+        return;
+    }
+    if (value && sim::displayFollowed)
+    {
+        sim::displayRising(pin);
+    }
+    sim::writePin(pin, value);
+}
+
+int digitalRead(uint8_t pin)
+{
+    return sim::pins[pin];
+}
+
+void analogReference(uint8_t)
+{
+}
+
+unsigned long millis()
+{
+    // Same width as on the target
+    return (uint32_t)(sim::localMicros() / 1000);
+}
+
+unsigned long micros()
+{
+    return (uint32_t)sim::localMicros();
+}
+
+void delay(unsigned long ms)
+{
+    sim::localAdvanceMicros((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    sim::localAdvanceMicros(us);
+}
+
+void attachInterrupt(uint8_t interrupt, void (*isr)(void), int mode)
+{
+    sim::attach(interrupt, isr, mode);
+}
+
+void detachInterrupt(uint8_t interrupt)
+{
+    sim::attach(interrupt, nullptr, 0);
+}
+
+void noInterrupts()
+{
+    sim::enableInterrupts(false);
+}
+
+void interrupts()
+{
+    sim::enableInterrupts(true);
+}
+
+void set_sleep_mode(int)
+{
+}
+
+void sleep_enable()
+{
+}
+
+void sleep_disable()
+{
+}
+
+void sleep_cpu()
+{
+}
+
+void power_all_disable()
+{
+}
+
+void power_all_enable()
+{
+}
+
+/*
+ * Serial *********************************************************************
+ */
+void HardwareSerial::begin(unsigned long)
+{
+}
+
+int HardwareSerial::available()
+{
+    return sim::serialAvailable();
+}
+
+int HardwareSerial::read()
+{
+    return sim::serialRead();
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    sim::serialSend((char)c);
+    return 1;
+}
+
+size_t HardwareSerial::print(const char *s)
+{
+    size_t n = 0;
+    while (*s)
+    {
+        n += write((uint8_t)*s++);
+    }
+    return n;
+}
+
+size_t HardwareSerial::print(char c)
+{
+    return write((uint8_t)c);
+}
+
+size_t HardwareSerial::print(int n)
+{
+    return print((long)n);
+}
+
+size_t HardwareSerial::print(unsigned int n)
+{
+    return print((unsigned long)n);
+}
+
+size_t HardwareSerial::print(long n)
+{
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%ld", n);
+    return print(buf);
+}
+
+size_t HardwareSerial::print(unsigned long n)
+{
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%lu", n);
+    return print(buf);
+}
+
+size_t HardwareSerial::println()
+{
+    return print("\r\n");
+}
+
+size_t HardwareSerial::println(const char *s)
+{
+    return print(s) + println();
+}
+
+size_t HardwareSerial::println(int n)
+{
+    return print(n) + println();
+}
+
+size_t HardwareSerial::println(unsigned int n)
+{
+    return print(n) + println();
+}
+
+size_t HardwareSerial::println(long n)
+{
+    return print(n) + println();
+}
+
+size_t HardwareSerial::println(unsigned long n)
+{
+    return print(n) + println();
+}
+
+/*
+ * Servo **********************************************************************
+ */
+Servo::Servo()
+{
+    isAttached = false;
+    position = 90;
+}
+
+uint8_t Servo::attach(int)
+{
+    isAttached = true;
+    sim::servoAttach(true);
+    return 1;
+}
+
+void Servo::detach()
+{
+    isAttached = false;
+    sim::servoAttach(false);
+}
+
+bool Servo::attached()
+{
+    return isAttached;
+}
+
+void Servo::write(int value)
+{
+    position = value;
+    sim::servoWrite(value, isAttached);
+}
+
+int Servo::read()
+{
+    return position;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/// Controls of the host simulation
+namespace sim
+{
+/// Size of the EEPROM (ATmega328P)
+const uint16_t eepromSize = 1024;
+/// EEPROM image
+extern uint8_t eeprom[eepromSize];
+
+/// Virtual time (in microseconds)
+uint64_t now();
+/// Advance the virtual clock
+void advance(unsigned long ms);
+/// Advance the virtual clock (in microseconds)
+void advanceMicros(unsigned long us);
+/// Make the clock of the board too fast (ppm > 0) or too slow (ppm < 0)
+void setClockDrift(long ppm);
+/// Time as seen by the board, in ms, without the 32-bit wrap of millis()
+uint64_t boardMillis();
+/// Advance the virtual clock up to a time seen by the board (without running it)
+void advanceToBoardMillis(uint64_t ms);
+
+/// Full scale of the battery ADC (same as board::batteryFullScaleMv)
+const unsigned long batteryFullScaleMv = 11000;
+/// Battery: voltage of new batteries (mV), drain by servo position written and by second attached (uV).
+/// Its voltage is converted at each timer0 overflow once the firmware starts the ADC.
+void setBattery(unsigned long mv, unsigned long uvByMove, unsigned long uvBySecond);
+/// Voltage of the battery now (mV)
+unsigned long batteryMillivolts();
+
+/// Drive an input pin from outside (raises the attached interrupt on edges)
+void setPin(uint8_t pin, uint8_t value);
+/// Drive an input pin at a time to come (us): the edge happens when the clock gets there, even in a delay()
+void schedulePin(uint64_t at, uint8_t pin, uint8_t value);
+/// Level of a pin
+uint8_t getPin(uint8_t pin);
+/// Total time a pin was high since the start (us)
+uint64_t pinHighMicros(uint8_t pin);
+
+/// Number of digits of the display
+const uint8_t displayDigits = 5;
+/// Decode the display from now on (off by default: it slows down long simulations)
+void followDisplay(bool follow);
+/// Text shown by the display, leftmost digit first: figures, ' ' (blank), '-', '?' (other),
+/// and '.' after a digit with its point
+std::string displayText();
+
+/// Press the encoder button (pin 2, active low)
+void pressButton();
+/// Release the encoder button
+void releaseButton();
+/// Turn the encoder by some detents (positive is clockwise), one detent every intervalMs
+void turnEncoder(int detents, unsigned long intervalMs = 10);
+
+/// Servo recorder
+struct ServoRecord
+{
+    unsigned long writes;       // Number of positions written while attached
+    unsigned long attaches;     // Number of times the servo was attached
+    uint64_t attachedUs;        // Total time attached
+    int position;               // Last position written
+};
+/// Servo activity since the start
+ServoRecord servo();
+/// Times of all the foot down positions (config address 0) written while attached
+const std::vector<uint64_t> &footDowns();
+/// Called by Servo on every write
+void servoWrite(int position, bool attached);
+/// Called by Servo on attach/detach
+void servoAttach(bool attached);
+
+/// Feed the serial port
+void serialInput(const char *text);
+/// Take everything sent on the serial port since last call
+std::string serialOutput();
+/// Echo the serial port output to stdout
+void serialEcho(bool echo);
+
+/// Byte sent on the serial port, with the time it is fully received on the other side
+struct SerialByte
+{
+    uint64_t at;
+    char c;
+};
+/// Everything sent on the serial port since the start (at 9600 bauds)
+const std::vector<SerialByte> &serialTrace();
+} // namespace sim
@@ -0,0 +1,487 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "Arduino.h"
+#include "sim.h"
+#include "harness.h"
+
+// The unit tests (test/) have their own main()
+#ifndef PIO_UNIT_TESTING
+
+// Firmware entry points
+void setup();
+
+namespace
+{
+using namespace harness;
+
+/// Seconds elapsed since start
+double wallTime(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/// Print the spread of the step durations
+void printCadence(const std::vector<uint64_t> &downs)
+{
+    if (downs.size() < 2)
+    {
+        return;
+    }
+    uint64_t shortest = UINT64_MAX;
+    uint64_t longest = 0;
+    for (size_t k = 1; k < downs.size(); k++)
+    {
+        uint64_t d = downs[k] - downs[k - 1];
+        shortest = (d < shortest) ? d : shortest;
+        longest = (d > longest) ? d : longest;
+    }
+    double mean = (double)(downs.back() - downs.front()) / (downs.size() - 1);
+    printf("Step duration   : mean %.2f ms (%.3f steps/min), min %.1f ms, max %.1f ms\n",
+           mean / 1000.0, 60e6 / mean, (double)shortest / 1000.0, (double)longest / 1000.0);
+}
+
+/// Names of the states, from PowerOff
+const char *stateNames[] = {"PowerOff", "Init", "SetSteps", "AdjustSteps", "Emulate", "Paused",
+                            "ChangeSpeed", "Finished", "EditConfig"};
+
+/// Record a session with fast spins, presses at the long press boundary and speed changes,
+/// and write the answers of J in a file (replayed with --input)
+int recordInput(const char *path)
+{
+    FILE *f = fopen(path, "w");
+    if (f == nullptr)
+    {
+        fprintf(stderr, "Cannot write %s\n", path);
+        return 1;
+    }
+    std::vector<uint8_t> bytes;
+    // Drain the trace (J) until it is empty, keeping the answers
+    auto drain = [&]() {
+        std::string answer;
+        do
+        {
+            answer = command("J");
+            fputs(answer.c_str(), f);
+        } while (appendTrace(answer, &bytes));
+    };
+    // The edges are driven at their time, also while the main loop waits (as on the board),
+    // on a whole ms as they are replayed
+    auto press = [](unsigned long ms) {
+        uint64_t at = (sim::now() / 1000 + 1) * 1000;
+        sim::schedulePin(at, pinButton, LOW);
+        sim::schedulePin(at + (uint64_t)ms * 1000, pinButton, HIGH);
+        run(ms + 1);
+    };
+    auto spin = [](int detents, unsigned long intervalMs) {
+        uint64_t at = (sim::now() / 1000 + 1) * 1000;
+        for (int k = 0; k < abs(detents); k++)
+        {
+            sim::schedulePin(at, pinEncoderB, (detents < 0) ? HIGH : LOW);
+            sim::schedulePin(at, pinEncoderA, LOW);
+            sim::schedulePin(at + (uint64_t)intervalMs * 500, pinEncoderA, HIGH);
+            at += (uint64_t)intervalMs * 1000;
+        }
+        sim::schedulePin(at, pinEncoderB, HIGH);
+        run(abs(detents) * intervalMs + 1);
+    };
+    boot(0, 0);
+    // Click, then a fast spin: some detents come within the debounce time
+    press(80);
+    run(100);
+    spin(20, 3);
+    run(2000);
+    drain();
+    // Long press just over the delay
+    press(1003);
+    run(5000);
+    drain();
+    // Speed changed between two half steps, then again with a fast spin
+    spin(3, 40);
+    run(137);
+    spin(-8, 4);
+    run(3000);
+    drain();
+    // Pause, go on, then stop with a long press
+    press(120);
+    run(1000);
+    press(90);
+    run(2000);
+    press(1500);
+    run(500);
+    drain();
+    fclose(f);
+    printf("Recorded        : %zu events, %zu bytes in %s\n", decodeTrace(bytes).size(), bytes.size(), path);
+    return 0;
+}
+
+/// Replay an input trace from power up (answers of J in a file) and compare the changes of state.
+/// The config is the default one, or a config image (answer of D).
+int replayInput(const char *path, const char *image)
+{
+    FILE *f = fopen(path, "r");
+    if (f == nullptr)
+    {
+        fprintf(stderr, "Cannot read %s\n", path);
+        return 1;
+    }
+    std::string text;
+    char buffer[256];
+    while (fgets(buffer, sizeof(buffer), f) != nullptr)
+    {
+        text += buffer;
+    }
+    fclose(f);
+    std::vector<uint8_t> bytes;
+    appendTrace(text, &bytes);
+    std::vector<InputEvent> recorded = decodeTrace(bytes);
+    if (recorded.empty())
+    {
+        fprintf(stderr, "No event in %s\n", path);
+        return 1;
+    }
+
+    // Power up with the same config, the edges driven at their time.
+    // Erased EEPROM: the firmware loads its default config.
+    memset(sim::eeprom, 0xff, sim::eepromSize);
+    if (image != nullptr)
+    { // Version, config and CRC: the CRC is not stored
+        std::vector<uint8_t> bytes;
+        for (size_t k = 0; (image[2 * k] != '\0') && (image[2 * k + 1] != '\0'); k++)
+        {
+            char hex[3] = {image[2 * k], image[2 * k + 1], '\0'};
+            bytes.push_back((uint8_t)strtoul(hex, nullptr, 16));
+        }
+        if (bytes.size() >= 2)
+        {
+            sim::eeprom[versionAddress] = bytes[0];
+            memcpy(sim::eeprom, bytes.data() + 1, bytes.size() - 2);
+        }
+    }
+    unsigned int lost = scheduleInputs(recorded);
+    setup();
+    std::vector<uint8_t> replayedBytes;
+    uint64_t end = recorded.back().at * 1000 + 1000000;
+    while (sim::now() < end)
+    {
+        sim::serialInput("J\n");
+        runUntil(sim::now() + 20000);
+        appendTrace(sim::serialOutput(), &replayedBytes);
+    }
+    std::vector<InputEvent> replayed = decodeTrace(replayedBytes);
+
+    // Changes of state, with their time after the last input (processing latency)
+    auto transitions = [](const std::vector<InputEvent> &events, std::vector<std::pair<InputEvent, uint64_t>> *out) {
+        uint64_t inputAt = 0;
+        for (const InputEvent &e : events)
+        {
+            if ((e.code & 0xc0) == 0x80)
+            {
+                out->push_back(std::make_pair(e, e.at - inputAt));
+            }
+            else
+            {
+                inputAt = e.at;
+            }
+        }
+    };
+    std::vector<std::pair<InputEvent, uint64_t>> expected;
+    std::vector<std::pair<InputEvent, uint64_t>> actual;
+    transitions(recorded, &expected);
+    transitions(replayed, &actual);
+    size_t inputs = recorded.size() - expected.size() - lost;
+    printf("Trace           : %zu inputs, %zu changes of state, %u losses\n", inputs, expected.size(), lost);
+    printf("  %10s  %-12s %14s %14s %12s\n", "time (ms)", "state", "latency (ms)", "replayed (ms)", "shift (ms)");
+    bool diverged = false;
+    uint64_t worst = 0;
+    for (size_t k = 0; k < expected.size(); k++)
+    {
+        const InputEvent &e = expected[k].first;
+        const char *name = stateNames[(e.code & 0x0f) % 9];
+        if ((k >= actual.size()) || (actual[k].first.code != e.code))
+        {
+            printf("  %10llu  %-12s %14llu %14s %12s  DIVERGED (%s)\n", (unsigned long long)e.at, name,
+                   (unsigned long long)expected[k].second, "-", "-",
+                   (k < actual.size()) ? stateNames[(actual[k].first.code & 0x0f) % 9] : "none");
+            diverged = true;
+            break;
+        }
+        long long shift = (long long)actual[k].first.at - (long long)e.at;
+        worst = ((uint64_t)llabs(shift) > worst) ? (uint64_t)llabs(shift) : worst;
+        printf("  %10llu  %-12s %14llu %14llu %+12lld\n", (unsigned long long)e.at, name,
+               (unsigned long long)expected[k].second, (unsigned long long)actual[k].second, shift);
+    }
+    if (!diverged && (actual.size() > expected.size()))
+    {
+        printf("  %10llu  %-12s %14s %14llu %12s  DIVERGED (not in the trace)\n", (unsigned long long)actual[expected.size()].first.at,
+               stateNames[(actual[expected.size()].first.code & 0x0f) % 9], "-", (unsigned long long)actual[expected.size()].second, "-");
+        diverged = true;
+    }
+    printf("Replay          : %s, worst time difference %llu ms\n", diverged ? "DIVERGED" : "same states", (unsigned long long)worst);
+    return diverged ? 2 : 0;
+}
+
+/// Write a vector to a pipe
+template <typename T> void send(int fd, const std::vector<T> &v)
+{
+    uint64_t n = v.size();
+    if ((write(fd, &n, sizeof(n)) != sizeof(n))
+        || ((n > 0) && (write(fd, v.data(), n * sizeof(T)) != (ssize_t)(n * sizeof(T)))))
+    {
+        exit(1);
+    }
+}
+
+/// Read a vector from a pipe
+template <typename T> std::vector<T> receive(int fd)
+{
+    uint64_t n = 0;
+    std::vector<T> v;
+    if (read(fd, &n, sizeof(n)) != sizeof(n))
+    {
+        return v;
+    }
+    v.resize(n);
+    size_t done = 0;
+    while (done < n * sizeof(T))
+    {
+        ssize_t r = read(fd, (char *)v.data() + done, n * sizeof(T) - done);
+        if (r <= 0)
+        {
+            v.clear();
+            return v;
+        }
+        done += r;
+    }
+    return v;
+}
+
+/// Run a simulated board in a child process (each one has its own firmware variables)
+template <typename F> std::vector<uint64_t> node(F body, std::vector<sim::SerialByte> *trace)
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        exit(1);
+    }
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        close(fds[0]);
+        body();
+        send(fds[1], sim::footDowns());
+        send(fds[1], sim::serialTrace());
+        _exit(0);
+    }
+    close(fds[1]);
+    std::vector<uint64_t> downs = receive<uint64_t>(fds[0]);
+    std::vector<sim::SerialByte> t = receive<sim::SerialByte>(fds[0]);
+    if (trace != nullptr)
+    {
+        *trace = t;
+    }
+    close(fds[0]);
+    waitpid(pid, nullptr, 0);
+    return downs;
+}
+
+/// Simulate a master and its followers wired on the serial bus
+int bus(unsigned int nodes, unsigned long steps, unsigned long speed, bool synchronized)
+{
+    std::vector<sim::SerialByte> trace;
+    uint64_t end = 0;
+    std::vector<uint64_t> master = node([&]() {
+        int state;
+        boot(1, 0);
+        session(steps, speed, &state);
+    }, &trace);
+    if (!trace.empty())
+    {
+        end = trace.back().at + 2000000;
+    }
+    printf("Master          : %zu steps\n", master.size());
+
+    int result = 0;
+    for (unsigned int i = 1; i < nodes; i++)
+    {
+        // Resonators: up to +/-0.5%
+        long drift = ((i % 2) ? 1 : -1) * (long)(1000 * ((i + 1) / 2));
+        std::vector<uint64_t> follower = node([&]() {
+            boot(synchronized ? 2 : 0, drift);
+            for (const sim::SerialByte &b : trace)
+            {
+                runUntil(b.at);
+                char c[2] = {b.c, '\0'};
+                sim::serialInput(c);
+            }
+            runUntil(end);
+        }, nullptr);
+
+        // Phase error against the closest foot down of the master, after the first 10 steps
+        uint64_t sum = 0;
+        uint64_t worst = 0;
+        size_t count = 0;
+        size_t m = 0;
+        for (size_t k = 10; k < follower.size(); k++)
+        {
+            while ((m + 1 < master.size()) && (master[m + 1] <= follower[k]))
+            {
+                m++;
+            }
+            uint64_t before = follower[k] - master[m];
+            uint64_t after = (m + 1 < master.size()) ? master[m + 1] - follower[k] : before;
+            uint64_t error = (before < after) ? before : after;
+            sum += error;
+            worst = (error > worst) ? error : worst;
+            count++;
+        }
+        printf("Follower %u      : %zu steps, drift %+ld ppm, phase error mean %.1f ms, max %.1f ms\n",
+               i, follower.size(), drift, count ? (double)sum / count / 1000.0 : 0.0, (double)worst / 1000.0);
+        if (follower.size() != master.size())
+        {
+            result = 2;
+        }
+    }
+    return result;
+}
+} // namespace
+
+/// Simulate a whole session: program [steps [speed]]
+/// or a bus of units:         program --bus <nodes> [--nosync] [steps [speed]]
+/// or a workout program:      program --program <hex>
+/// with a human-like cadence:  program --cadence <jitter> <drift> <fatigue> ...
+/// replaying the recorded gait: program --replay ...
+/// recording an input trace:   program --record <file>
+/// replaying an input trace:   program --input <file> [--image <hex>]
+/// The checks of each feature are the unit tests (test/, pio test -e native).
+int main(int argc, char *argv[])
+{
+    unsigned int nodes = 0;
+    bool synchronized = true;
+    const char *programHex = nullptr;
+    const char *cadence[3] = {nullptr, nullptr, nullptr};
+    bool replay = false;
+    const char *recordPath = nullptr;
+    const char *inputPath = nullptr;
+    const char *image = nullptr;
+    int arg = 1;
+    while ((arg < argc) && (argv[arg][0] == '-'))
+    {
+        if ((strcmp(argv[arg], "--bus") == 0) && (arg + 1 < argc))
+        {
+            nodes = (unsigned int)strtoul(argv[++arg], nullptr, 10);
+        }
+        else if ((strcmp(argv[arg], "--program") == 0) && (arg + 1 < argc))
+        {
+            programHex = argv[++arg];
+        }
+        else if ((strcmp(argv[arg], "--cadence") == 0) && (arg + 3 < argc))
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                cadence[i] = argv[++arg];
+            }
+        }
+        else if ((strcmp(argv[arg], "--record") == 0) && (arg + 1 < argc))
+        {
+            recordPath = argv[++arg];
+        }
+        else if ((strcmp(argv[arg], "--input") == 0) && (arg + 1 < argc))
+        {
+            inputPath = argv[++arg];
+        }
+        else if ((strcmp(argv[arg], "--image") == 0) && (arg + 1 < argc))
+        {
+            image = argv[++arg];
+        }
+        else if (strcmp(argv[arg], "--replay") == 0)
+        {
+            replay = true;
+        }
+        else if (strcmp(argv[arg], "--nosync") == 0)
+        {
+            synchronized = false;
+        }
+        arg++;
+    }
+    unsigned long steps = (argc > arg) ? strtoul(argv[arg], nullptr, 10) : 20000;
+    unsigned long speed = (argc > arg + 1) ? strtoul(argv[arg + 1], nullptr, 10) : 100;
+    std::chrono::steady_clock::time_point wallStart = std::chrono::steady_clock::now();
+
+    if (recordPath != nullptr)
+    {
+        return recordInput(recordPath);
+    }
+    if (inputPath != nullptr)
+    {
+        int result = replayInput(inputPath, image);
+        printf("Wall time       : %.3f s\n", wallTime(wallStart));
+        return result;
+    }
+    if (nodes > 1)
+    {
+        int result = bus(nodes, steps, speed, synchronized);
+        printf("Wall time       : %.3f s\n", wallTime(wallStart));
+        return result;
+    }
+
+    int state = 0;
+    boot(0, 0);
+    if (replay)
+    {
+        char cmd[32];
+        snprintf(cmd, sizeof(cmd), "W %d 1", gaitReplayAddress);
+        command(cmd);
+    }
+    for (int i = 0; (i < 3) && (cadence[i] != nullptr); i++)
+    {
+        char cmd[32];
+        snprintf(cmd, sizeof(cmd), "W %d %s", cadenceAddress + i, cadence[i]);
+        if (command(cmd).compare(0, 2, "OK") != 0)
+        {
+            fprintf(stderr, "Cadence refused: %s\n", cmd);
+            exit(1);
+        }
+    }
+    if (programHex != nullptr)
+    {
+        loadProgram(programHex);
+        steps = 0;
+    }
+    uint64_t startedAt = sim::now();
+    uint64_t displayOnFrom = sim::pinHighMicros(pinDigitEnable);
+    unsigned long remaining = session(steps, speed, &state);
+
+    double simulated = (double)(sim::now() - startedAt) / 1e6;
+    sim::ServoRecord servo = sim::servo();
+    if (programHex != nullptr)
+    {
+        if (!replay)
+        { // A recorded gait does not go exactly to the foot down position
+            printf("Program         : %zu steps\n", sim::footDowns().size());
+        }
+        printf("Simulated time  : %.1f s\n", simulated);
+    }
+    else
+    {
+        printf("Steps requested : %lu at %lu steps/min\n", steps, speed);
+        printf("Steps remaining : %lu (state %d)\n", remaining, state);
+        printf("Simulated time  : %.1f s (expected %.1f s)\n", simulated, steps * 60.0 / speed);
+    }
+    if (!replay)
+    {
+        printCadence(sim::footDowns());
+    }
+    printf("Servo           : %lu positions, %lu attach, %.1f s attached\n",
+           servo.writes, servo.attaches, (double)servo.attachedUs / 1e6);
+    printf("Display         : digits on %.1f %% of the time\n",
+           100.0 * (double)(sim::pinHighMicros(pinDigitEnable) - displayOnFrom) / (double)(sim::now() - startedAt));
+    // Counters since power up, for energy.py
+    printf("Energy          : %s", command("E").c_str());
+    printf("Wall time       : %.3f s\n", wallTime(wallStart));
+    return (remaining == 0) ? 0 : 2;
+}
+#endif
@@ -0,0 +1,231 @@
+#pragma once
+
+#include "globals.h"
+
+/// Battery monitor, running in the background.
+///
+/// The ADC converts the battery voltage (board::pinBattery, through a divider,
+/// against the internal 1.1 V reference) at each overflow of timer0 (auto
+/// trigger, about 976 times by second). The ADC interrupt sums 64 conversions
+/// into a 13-bit reading (oversampling and decimation): the main loop only
+/// picks up a result about 15 times by second and never waits for the ADC.
+///
+/// The drop of voltage by step is measured while walking (it includes the
+/// servo duty at the actual cadence), giving the steps left before
+/// config.batt_off and the runtime at the current speed.
+/// Below config.batt_low the buzzer clicks every warnPeriod; below
+/// config.batt_off the session is saved in EEPROM and the unit goes to sleep.
+/// The saved session is restored at the next Init.
+namespace battery
+{
+/// Conversions summed by reading (4^3: 3 more bits)
+const uint8_t oversampling = 64;
+/// Steps between two measures of the drop of voltage
+const unsigned int drainSteps = 1024;
+/// Time between two warnings (ms)
+const unsigned long warnPeriod = 10000;
+/// Saved session in EEPROM: marker, steps remaining (4 bytes), speed (between the config and the programs)
+const unsigned int checkpointAddress = 0x38;
+const uint8_t checkpointMarker = 0xa5;
+/// Threshold left erased in EEPROM: no threshold
+const uint8_t thresholdErased = 0xff;
+
+/// Levels of the battery
+enum Levels : uint8_t {
+  Unknown = 0,
+  Good,
+  Low,
+  Critical
+};
+
+/// Sum of the conversions of the actual reading and their number
+volatile uint16_t sampleSum = 0;
+volatile uint8_t sampleCount = 0;
+/// Last reading (13 bits) and is it new?
+volatile uint16_t reading;
+volatile bool readingReady = false;
+/// Readings left to drop after the start (the reference settles)
+uint8_t readingsToSkip = 2;
+
+/// Filtered voltage (mV)
+unsigned int voltage = 0;
+/// Actual level
+Levels level = Levels::Unknown;
+/// Steps counted since the last drain measure and voltage at this measure
+unsigned int drainCount = 0;
+unsigned int drainFrom = 0;
+/// Drop of voltage by step (µV), 0 while unknown
+unsigned long drainByStep = 0;
+/// Time of the last warning
+tick_t warnedAt = 0;
+
+/// Start the conversions (the ADC runs on its own from now on)
+void setupBattery()
+{
+  if (!features::battery)
+  {
+    return;
+  }
+  DIDR0 |= bit(board::pinBattery - A0); // No digital input buffer on the battery pin
+  ADMUX = bit(REFS1) | bit(REFS0) | (board::pinBattery - A0); // Internal 1.1 V reference
+  ADCSRB = bit(ADTS2); // Auto trigger on timer0 overflow
+  ADCSRA = bit(ADEN) | bit(ADATE) | bit(ADIF) | bit(ADIE) | bit(ADPS2) | bit(ADPS1) | bit(ADPS0); // 125 kHz
+}
+
+/// A conversion is done (ADC interrupt)
+inline void onSample(uint16_t sample)
+{
+  sampleSum += sample;
+  if (++sampleCount == oversampling)
+  {
+    reading = sampleSum >> 3;
+    readingReady = true;
+    sampleSum = 0;
+    sampleCount = 0;
+  }
+}
+
+/// Called by movements at each foot down
+void onFootDown()
+{
+  if (!features::battery || (voltage == 0))
+  {
+    return;
+  }
+  if (++drainCount >= drainSteps)
+  {
+    if (drainFrom > voltage)
+    { // Mean with the previous measure: the load makes the voltage noisy
+      unsigned long drain = ((unsigned long)(drainFrom - voltage) * 1000UL) / drainSteps;
+      drainByStep = (drainByStep == 0) ? drain : (drainByStep + drain) / 2;
+    }
+    drainFrom = voltage;
+    drainCount = 0;
+  }
+}
+
+/// Voltage of a threshold of the config (mV). 0 and 0xff (erased EEPROM) are not set: 0.
+unsigned int threshold(uint8_t setting)
+{
+  return ((setting == 0) || (setting == thresholdErased)) ? 0 : (unsigned int)setting * 100U;
+}
+
+/// Steps that can still be done before config.batt_off (0xffffffff: unknown)
+unsigned long stepsLeft()
+{
+  unsigned int off = threshold(config.batt_off);
+  if (drainByStep == 0)
+  {
+    return 0xffffffffUL;
+  }
+  if (voltage <= off)
+  {
+    return 0;
+  }
+  return ((unsigned long)(voltage - off) * 1000UL) / drainByStep;
+}
+
+/// Runtime left at the current speed (minutes, 0xffffffff: unknown)
+unsigned long minutesLeft()
+{
+  unsigned long steps = stepsLeft();
+  return (steps == 0xffffffffUL) ? steps : steps / movements::speed;
+}
+
+/// Save the session to resume it after the batteries are changed
+void saveCheckpoint()
+{
+  EEPROM.put(checkpointAddress + 1, (uint32_t)movements::stepsRemaining);
+  EEPROM.update(checkpointAddress + 5, movements::speed);
+  EEPROM.update(checkpointAddress, checkpointMarker);
+}
+
+/// Restore a saved session (once). Returns true if there was one.
+bool restoreCheckpoint()
+{
+  if (!features::battery || (EEPROM.read(checkpointAddress) != checkpointMarker))
+  {
+    return false;
+  }
+  EEPROM.update(checkpointAddress, 0xff);
+  uint32_t steps;
+  EEPROM.get(checkpointAddress + 1, steps);
+  uint8_t speed = EEPROM.read(checkpointAddress + 5);
+  if ((steps == 0) || (steps > config.steps_max) || (speed < config.speed_min) || (speed > config.speed_max))
+  {
+    return false;
+  }
+  movements::stepsRemaining = steps;
+  movements::speed = speed;
+  return true;
+}
+
+/// Pick up a new reading and act on the level. Must be called from the main loop.
+void pollBattery()
+{
+  if (!features::battery || !readingReady)
+  {
+    return;
+  }
+  noInterrupts();
+  uint16_t r = reading;
+  readingReady = false;
+  interrupts();
+  if (readingsToSkip > 0)
+  {
+    readingsToSkip--;
+    return;
+  }
+  unsigned int mv = ((uint32_t)r * board::batteryFullScaleMv) >> 13;
+  voltage = (voltage == 0) ? mv : voltage - (voltage >> 2) + (mv >> 2);
+  if (drainFrom == 0)
+  {
+    drainFrom = voltage;
+  }
+
+  unsigned int low = threshold(config.batt_low);
+  unsigned int off = threshold(config.batt_off);
+  if (low == 0)
+  {
+    level = Levels::Unknown;
+    return;
+  }
+  // 50 mV of hysteresis: the voltage goes back up when the servo stops
+  if (voltage < off)
+  {
+    level = Levels::Critical;
+  }
+  else if (voltage < low)
+  {
+    level = Levels::Low;
+  }
+  else if (voltage > low + 50U)
+  {
+    level = Levels::Good;
+  }
+
+  bool emulating = (stateMachine::state == stateMachine::States::Emulate)
+                || (stateMachine::state == stateMachine::States::ChangeSpeed)
+                || (stateMachine::state == stateMachine::States::Paused);
+  if (!emulating)
+  {
+    return;
+  }
+  if (level == Levels::Critical)
+  { // Before the brownout: keep the steps remaining and sleep
+    saveCheckpoint();
+    movements::stopMovements();
+    stateMachine::changeState(stateMachine::States::PowerOff);
+  }
+  else if ((level == Levels::Low) && (ticksSince(warnedAt, ticks()) >= warnPeriod))
+  {
+    warnedAt = ticks();
+    buzzer::clicBuzzer();
+  }
+}
+} // namespace battery
+
+ISR(ADC_vect)
+{
+  battery::onSample(ADC);
+}
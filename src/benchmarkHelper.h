@@ -0,0 +1,178 @@
+#pragma once
+
+#include "globals.h"
+
+/// Measures the hot paths (only built with -DBENCHMARK, see bench.py).
+///
+/// Each function is called `iterations` times and the average duration is
+/// sent on the serial port, in CPU cycles, as one line per function:
+/// `BENCH <name> <cycles>`. The report ends with `BENCH END`.
+/// The cycles are counted by timer1 without prescaler, taken from the servo
+/// library (no servo pulses while measuring), with the interrupts disabled
+/// during each call: the timer0 interrupt is not counted. The latency of the
+/// encoder interrupt is measured on an edge made by the firmware itself.
+/// Under simavr the clock is exact, so the numbers are reproducible.
+namespace benchmark
+{
+/// Number of calls for each measure
+const unsigned int iterations = 256;
+
+/// Overhead of a measure itself (in cycles)
+unsigned long overhead;
+
+/// Empty function used to measure the overhead of a call
+void __attribute__((noinline)) nothing()
+{
+    asm volatile("");
+}
+
+/// Duration of one call (in cycles, up to 2 overflows of timer1: 131071 cycles)
+unsigned long cycles(void (*fn)())
+{
+    noInterrupts();
+    TIMSK1 = 0;
+    TCCR1A = 0;
+    TCCR1B = bit(CS10);
+    TCNT1 = 0;
+    TIFR1 = bit(TOV1);
+    fn();
+    uint16_t count = TCNT1;
+    bool overflow = TIFR1 & bit(TOV1);
+    interrupts();
+    return count + (overflow ? 0x10000UL : 0);
+}
+
+/// Measure the average duration of a function (in cycles)
+unsigned long measure(void (*fn)())
+{
+    unsigned long elapsed = 0;
+    for (unsigned int i = 0; i < iterations; i++)
+    {
+        elapsed += cycles(fn);
+    }
+    elapsed /= iterations;
+    return (elapsed > overhead) ? elapsed - overhead : 0;
+}
+
+/// Send one result
+void report(const char *name, unsigned long cycles)
+{
+    Serial.print("BENCH ");
+    Serial.print(name);
+    Serial.print(' ');
+    Serial.println(cycles);
+}
+
+void benchDisplayNextDigit()
+{
+    userinterface::disp.displayNextDigit();
+}
+
+void benchDisplayWrite()
+{
+    userinterface::displaySteps();
+}
+
+void benchWalkIdle()
+{
+    movements::walk();
+}
+
+/// Measure the duration of a step (in cycles), waiting for each step to be due
+unsigned long measureWalkStep()
+{
+    const unsigned char count = 16;
+    unsigned long elapsed = 0;
+    for (unsigned char i = 0; i < count; i++)
+    {
+        delay(30000U / movements::speed + 1);
+        elapsed += cycles(benchWalkIdle);
+    }
+    elapsed /= count;
+    return (elapsed > overhead) ? elapsed - overhead : 0;
+}
+
+void benchDoState()
+{
+    stateMachine::doState();
+}
+
+void benchButtonCheck()
+{
+    userinterface::encbtn.check();
+}
+
+void benchEncoderTurned()
+{
+    userinterface::onEncoderTurned();
+    userinterface::rot = 0;
+}
+
+/// Timer1 count when the attached function of the interrupt under test starts
+volatile uint16_t isrAt;
+volatile bool isrDone;
+
+void probeIsr()
+{
+    isrAt = TCNT1;
+    isrDone = true;
+}
+
+/// Latency of INT1 (encoder A), in cycles from the falling edge to the start of its attached
+/// function: the firmware makes the edge itself, INT1 fires on an output pin too.
+/// timer0 is stopped meanwhile, so no other interrupt delays it.
+unsigned long measureIsrLatency()
+{
+    volatile uint8_t *port = portOutputRegister(digitalPinToPort(board::pinEncA));
+    uint8_t mask = digitalPinToBitMask(board::pinEncA);
+    attachInterrupt(digitalPinToInterrupt(board::pinEncA), probeIsr, FALLING);
+    digitalWrite(board::pinEncA, HIGH);
+    pinMode(board::pinEncA, OUTPUT);
+    uint8_t timer0 = TIMSK0;
+    TIMSK0 = 0;
+    TIMSK1 = 0;
+    TCCR1A = 0;
+    TCCR1B = bit(CS10);
+    unsigned long elapsed = 0;
+    for (unsigned int i = 0; i < iterations; i++)
+    {
+        isrDone = false;
+        EIFR = bit(INTF1);
+        TCNT1 = 0;
+        *port &= ~mask;
+        while (!isrDone && (TCNT1 < 60000U))
+        {
+        }
+        elapsed += isrAt;
+        *port |= mask;
+    }
+    TIMSK0 = timer0;
+    pinMode(board::pinEncA, INPUT);
+    attachInterrupt(digitalPinToInterrupt(board::pinEncA), userinterface::onEncoderTurned, FALLING);
+    return elapsed / iterations;
+}
+
+/// Run all the measures and send the report
+void run()
+{
+    overhead = 0;
+    overhead = measure(nothing);
+    // Dimmed: the digit time is a busy loop (delay() needs the interrupts)
+    userinterface::disp.setBrightness(BRIGHTNESS_MAX / 2);
+    report("displayNextDigit", measure(benchDisplayNextDigit));
+    report("displaySteps", measure(benchDisplayWrite));
+    report("Button::check", measure(benchButtonCheck));
+    report("onEncoderTurned", measure(benchEncoderTurned));
+    report("latency(INT1)", measureIsrLatency());
+    stateMachine::changeState(stateMachine::States::SetSteps);
+    report("doState(SetSteps)", measure(benchDoState));
+    config.servo_settle = 0; // Servo held: attaching it again would take timer1 back
+    movements::stepsRemaining = 10000;
+    movements::walk(); // Start walking
+    report("walk(idle)", measure(benchWalkIdle));
+    movements::speed = config.speed_max;
+    report("walk(step)", measureWalkStep());
+    movements::powerOffMovements();
+    Serial.println("BENCH END");
+}
+} // namespace benchmark
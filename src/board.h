@@ -0,0 +1,89 @@
+#pragma once
+
+#include <Arduino.h>
+
+/// Wiring of the board, known at compile time
+namespace board
+{
+/// Rotary encoder: switch (INT0), A (INT1) and B
+constexpr uint8_t pinEncS = 2;
+constexpr uint8_t pinEncA = 3;
+constexpr uint8_t pinEncB = 4;
+/// Display: shift register (data, clock, strobe), CD4017 reset and digit enable
+constexpr uint8_t pinSrDi = 5;
+constexpr uint8_t pinSrCk = 6;
+constexpr uint8_t pinSrSt = 7;
+constexpr uint8_t pinCd4017Mr = 8;
+constexpr uint8_t pinDigitEna = 9;
+/// The display pins as a type, for the Display template: each write is a single instruction
+struct DisplayPins
+{
+  static constexpr uint8_t clock = pinSrCk;
+  static constexpr uint8_t data = pinSrDi;
+  static constexpr uint8_t strobe = pinSrSt;
+  static constexpr uint8_t reset = pinCd4017Mr;
+  static constexpr uint8_t enable = pinDigitEna;
+};
+/// Servo (timer1: only 9 or 10)
+constexpr uint8_t pinServo = 10;
+/// Buzzer
+constexpr uint8_t pinBuzzer = 11;
+/// Power of the external components
+constexpr uint8_t pinPower = 12;
+/// Battery, through a divider: full scale of the ADC with the 1.1 V reference (mV)
+constexpr uint8_t pinBattery = A0;
+constexpr unsigned long batteryFullScaleMv = 11000;
+/// Pulse at each foot down, for external verification
+constexpr uint8_t pinStepSync = A1;
+/// Wake up from sleep (INT0 = encoder switch)
+constexpr uint8_t pinWakeUp = pinEncS;
+
+static_assert((pinServo == 9) || (pinServo == 10), "The servo library only drives pins 9 and 10 (timer1)");
+static_assert((pinServo != pinDigitEna), "The servo and the display share a pin");
+static_assert((pinEncA == 2) || (pinEncA == 3), "Encoder A needs a hardware interrupt (pin 2 or 3)");
+static_assert(pinWakeUp == 2, "Wake up is done by INT0 (pin 2)");
+static_assert((pinBattery >= A0) && (pinBattery <= A0 + 5), "The battery must be on an analog input");
+static_assert((pinStepSync != pinBattery) && (pinStepSync > 1), "The step sync pulse needs a free pin (not the serial port)");
+} // namespace board
+
+/// Optional features, all built by default. Build with -DFEATURE_xxx=0 to leave one out:
+/// its calls are constant false conditions, so the code and tables are not linked.
+#ifndef FEATURE_SYNC
+#define FEATURE_SYNC 1
+#endif
+#ifndef FEATURE_PROGRAMS
+#define FEATURE_PROGRAMS 1
+#endif
+#ifndef FEATURE_CADENCE
+#define FEATURE_CADENCE 1
+#endif
+#ifndef FEATURE_GAIT_REPLAY
+#define FEATURE_GAIT_REPLAY 1
+#endif
+#ifndef FEATURE_BATTERY
+#define FEATURE_BATTERY 1
+#endif
+#ifndef FEATURE_STEP_LOG
+#define FEATURE_STEP_LOG 1
+#endif
+#ifndef FEATURE_INPUT_TRACE
+#define FEATURE_INPUT_TRACE 1
+#endif
+
+namespace features
+{
+/// Synchronization with other units (syncHelper.h)
+constexpr bool sync = FEATURE_SYNC;
+/// Workout programs from EEPROM (programHelper.h)
+constexpr bool programs = FEATURE_PROGRAMS;
+/// Human-like cadence: jitter, drift and fatigue (cadenceHelper.h)
+constexpr bool cadence = FEATURE_CADENCE;
+/// Replay of the recorded gait (gaitTrace.h)
+constexpr bool gaitReplay = FEATURE_GAIT_REPLAY;
+/// Battery monitor (batteryHelper.h)
+constexpr bool battery = FEATURE_BATTERY;
+/// Step sync pulse and step log (stepLogHelper.h)
+constexpr bool stepLog = FEATURE_STEP_LOG;
+/// Recorder of the inputs (inputTraceHelper.h)
+constexpr bool inputTrace = FEATURE_INPUT_TRACE;
+} // namespace features
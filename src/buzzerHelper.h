@@ -5,38 +5,39 @@
 /// Methods to use a buzzer
 namespace buzzer
 {
-/// Pin on which the buzzer is connected
-const uint8_t pinBuzzer=11;
+/// Number of clicks (for the energy counters)
+unsigned long clicCount = 0;
 
 /// Initialize the buzzer
 void setupBuzzer()
 {
-    pinMode(pinBuzzer, OUTPUT);
-    digitalWrite(pinBuzzer, HIGH);
+    pinMode(board::pinBuzzer, OUTPUT);
+    digitalWrite(board::pinBuzzer, HIGH);
 }
 
 /// Tests the buzzer
 void testBuzzer(unsigned long duration)
 {
-    digitalWrite(pinBuzzer, millis() <= duration);
+    digitalWrite(board::pinBuzzer, millis() <= duration);
 }
 
 /// Emits a short "clic" sound
 void clicBuzzer() {
-    bool clic = digitalRead(pinBuzzer);
-    digitalWrite(pinBuzzer, !clic);
+    clicCount++;
+    bool clic = digitalRead(board::pinBuzzer);
+    digitalWrite(board::pinBuzzer, !clic);
     delay(2);
-    digitalWrite(pinBuzzer, clic);
+    digitalWrite(board::pinBuzzer, clic);
 }
 
 /// Mutes the buzzer
 void muteBuzzer() {
-    digitalWrite(pinBuzzer, LOW);
+    digitalWrite(board::pinBuzzer, LOW);
 }
 
 /// Ring the buzzer
 void ringBuzzer() {
-    digitalWrite(pinBuzzer, HIGH);
+    digitalWrite(board::pinBuzzer, HIGH);
 }
 
 } // namespace buzzer
@@ -0,0 +1,203 @@
+#pragma once
+
+#include "globals.h"
+
+/// Cadence modulation: steps are not as regular as a metronome.
+///
+/// Half steps are scheduled on a regular grid (30000 / speed ms) plus an offset made of:
+///  - jitter: random, up to config.var_jitter % of a half step (at most a quarter of it)
+///  - drift: slow sine wave, the cadence goes up and down by config.var_drift %
+///  - fatigue: the cadence is config.var_fatigue % faster at the start and slower at the end
+/// Drift and fatigue are 0 on the first and on the last foot down of the session, and the
+/// jitter is bounded, so the mean speed over the session is the requested one.
+/// Amplitudes are computed once by session (start()); a half step only costs
+/// a xorshift, a multiplication and additions, without any division.
+namespace cadence
+{
+/// One period of sine, amplitude 127 (one more entry for interpolation)
+const int8_t sineTable[65] PROGMEM = {
+      0,   12,   25,   37,   49,   60,   71,   81,   90,   98,  106,  112,  117,  122,  125,  126,
+    127,  126,  125,  122,  117,  112,  106,   98,   90,   81,   71,   60,   49,   37,   25,   12,
+      0,  -12,  -25,  -37,  -49,  -60,  -71,  -81,  -90,  -98, -106, -112, -117, -122, -125, -126,
+   -127, -126, -125, -122, -117, -112, -106,  -98,  -90,  -81,  -71,  -60,  -49,  -37,  -25,  -12,
+      0
+};
+/// Usual length of a drift period (steps), adjusted to fit a whole number of periods in a session
+const unsigned int driftPeriod = 1024;
+/// Largest drift and fatigue (%, config.var_drift and config.var_fatigue, see registers::map)
+const uint8_t driftMax = 10;
+const uint8_t fatigueMax = 20;
+/// Longest session with a fatigue curve (steps)
+const unsigned long fatigueStepsMax = 65535;
+
+/// State of the xorshift generator (never 0)
+uint16_t seed = 0xace1;
+/// Time of the next half step on the regular grid, and with its offset
+tick_t gridAt;
+tick_t scheduledAt;
+/// Duration of a half step (ms) and speed it was computed for
+unsigned int halfPeriod;
+unsigned char periodSpeed = 0;
+/// Fraction of ms of a half step (in 1/speed ms) and its accumulator: 30000 / speed is not a whole number of ms
+uint8_t periodRemainder;
+unsigned int periodError = 0;
+/// Jitter amplitude (ms)
+uint8_t jitterAmplitude;
+/// Drift: amplitude (ms), phase (6.26 entries of sineTable: wraps with the table), phase by step and actual offset (ms)
+long driftAmplitude;
+uint32_t driftPhase;
+uint32_t driftIncrement;
+long driftOffset;
+/// Fatigue offset, its change by step and the change of the change (ms, 32.32 fixed point)
+int64_t fatigue;
+int64_t fatigueSlope;
+int64_t fatigueCurve;
+/// Steps remaining on the fatigue curve
+unsigned int curveSteps;
+
+/// Next pseudo random number (xorshift)
+uint16_t nextRandom()
+{
+  seed ^= seed << 7;
+  seed ^= seed >> 9;
+  seed ^= seed << 8;
+  return seed;
+}
+
+/// Update the half step duration after a change of speed (the only division)
+void updatePeriod()
+{
+  if (movements::speed != periodSpeed)
+  {
+    periodSpeed = movements::speed;
+    halfPeriod = 30000U / (unsigned int)periodSpeed; // 60000 / 2
+    periodRemainder = 30000U - halfPeriod * periodSpeed;
+    periodError = 0;
+  }
+}
+
+/// Start the drift and fatigue curves for a session of `steps` steps
+void startCurves(unsigned long steps)
+{
+  updatePeriod();
+  if (!features::cadence)
+  { // Regular grid only
+    return;
+  }
+  unsigned long jitter = (unsigned long)halfPeriod * config.var_jitter / 100UL;
+  jitterAmplitude = (jitter > 255) ? 255 : jitter;
+
+  driftPhase = 0;
+  driftOffset = 0;
+  driftAmplitude = 0;
+  // Out of range values (written with W) are limited
+  uint8_t drift = (config.var_drift > driftMax) ? driftMax : config.var_drift;
+  uint8_t tiredness = (config.var_fatigue > fatigueMax) ? fatigueMax : config.var_fatigue;
+  if ((drift > 0) && (steps > 1))
+  { // A whole number of periods from the first to the last foot down (steps - 1 steps later):
+    // the drift is back to 0 at the end. Rounded up: the phase ends just past the last period,
+    // by less than the fraction used for the interpolation.
+    unsigned long span = steps - 1;
+    unsigned long periods = (span + driftPeriod / 2) / driftPeriod;
+    periods = (periods == 0) ? 1 : periods;
+    driftIncrement = (uint32_t)((((uint64_t)periods << 32) + span - 1) / span);
+    // Offset amplitude making the cadence change by var_drift %: pct / 100 * 2 halfPeriod * period / (2 pi)
+    driftAmplitude = (long)drift * halfPeriod * (span / periods) / 314L;
+    driftAmplitude = (driftAmplitude > 1000000L) ? 1000000L : driftAmplitude; // No overflow in onFootDown()
+  }
+
+  // Offset -c.k.(M-k)/M at foot down k (c: var_fatigue % of a step, M = steps - 1): 0 on the
+  // first and the last foot down, and the step duration goes linearly from (1 - var_fatigue %)
+  // to (1 + var_fatigue %).
+  // Not for longer sessions: the offset would reach hours (and overflow)
+  fatigue = 0;
+  fatigueSlope = 0;
+  fatigueCurve = 0;
+  curveSteps = 0;
+  if ((tiredness > 0) && (steps > 2) && (steps <= fatigueStepsMax))
+  {
+    unsigned int span = steps - 1;
+    fatigueCurve = ((int64_t)tiredness * 2 * halfPeriod << 33) / (100 * (int64_t)span);
+    // Rounded towards 0: the offset ends at 0 (or a fraction of ms above)
+    fatigueSlope = -((int64_t)(span - 1) * fatigueCurve) / 2;
+    curveSteps = span;
+  }
+}
+
+/// Start a session: first half step at `now`
+void start(tick_t now, unsigned long steps)
+{
+  seed ^= (uint16_t)micros();
+  seed = (seed == 0) ? 0xace1 : seed;
+  gridAt = now;
+  scheduledAt = now;
+  startCurves(steps);
+}
+
+/// Move the grid by some ms (wait, or align on another unit)
+void shift(long ms)
+{
+  gridAt += ms;
+  scheduledAt += ms;
+}
+
+/// Move the grid so that the next half step is at `at`
+void restartAt(tick_t at)
+{
+  shift(ticksUntil(at, scheduledAt));
+}
+
+/// Advance the curves by one step (at each foot down)
+void onFootDown()
+{
+  if (!features::cadence)
+  {
+    return;
+  }
+  if (curveSteps > 0)
+  {
+    curveSteps--;
+    fatigue += fatigueSlope;
+    fatigueSlope += fatigueCurve;
+  }
+  if (driftAmplitude != 0)
+  { // Linear interpolation between two entries of the table
+    driftPhase += driftIncrement;
+    uint8_t index = driftPhase >> 26;
+    int8_t a = (int8_t)pgm_read_byte(&sineTable[index]);
+    int8_t b = (int8_t)pgm_read_byte(&sineTable[index + 1]);
+    int sine = (a << 4) + (b - a) * (int)((driftPhase >> 22) & 15); // +/-2032
+    driftOffset = (driftAmplitude * sine) >> 11;
+  }
+}
+
+/// Time of the next half step, `now` being the actual one
+tick_t nextHalfStep(tick_t now)
+{
+  updatePeriod();
+  if (ticksUntil(scheduledAt, now) < -(int32_t)halfPeriod)
+  { // Far behind (paused, busy main loop): move the grid instead of catching up
+    gridAt += ticksSince(scheduledAt, now);
+  }
+  gridAt += halfPeriod;
+  periodError += periodRemainder;
+  if (periodError >= periodSpeed)
+  {
+    periodError -= periodSpeed;
+    gridAt++;
+  }
+  if (!features::cadence)
+  {
+    scheduledAt = gridAt;
+    return scheduledAt;
+  }
+  long offset = driftOffset + (long)(fatigue >> 32);
+  if (jitterAmplitude > 0)
+  {
+    uint8_t amplitude = ((halfPeriod >> 2) < jitterAmplitude) ? (halfPeriod >> 2) : jitterAmplitude;
+    offset += ((int)(int8_t)nextRandom() * amplitude) >> 7;
+  }
+  scheduledAt = gridAt + offset;
+  return scheduledAt;
+}
+} // namespace cadence
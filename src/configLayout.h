@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdint.h>
+
+/// Internal configuration (stored in EEPROM at address 0, packed: same layout on the host).
+/// Declarations only: the host harness (lib/NativeSim) takes the addresses of the fields from here.
+struct __attribute__((packed)) MyConfig_t {
+  unsigned char pos_stepdown;         // Servo motor position when foot is down
+  unsigned char pos_stepup;           // Servo motor position when foot is up
+  uint32_t      steps_init;           // Number of steps by default (at startup)
+  uint32_t      steps_min;            // Number of steps at minimum
+  uint32_t      steps_max;            // Number of steps at maximum
+  unsigned char speed_init;           // Default speed (at startup) (steps by minute)
+  unsigned char speed_min;            // Lowest speed (steps by minute)
+  unsigned char speed_max;            // Highest speed (steps by minute)
+  unsigned char step_ratio;           // Step ratio (step up/down)
+  unsigned char delay_longpress;      // Delay for a long press (previously LONG_PRESS) but in 10th of seconds
+  unsigned char delay_set;            // Delay to exit set mode (previously DIGIT_TIMEOUT) but in 10th of seconds
+  unsigned char delay_off;            // Delay before displaying OFF message (in seconds)
+  unsigned char delay_offmsg;         // Delay before auto power off after OFF message (in 10th of seconds)
+  unsigned char sync_mode;            // Synchronization with other units (0: none, 1: master, 2: follower)
+  unsigned char servo_settle;         // Time for the servo to reach its position before releasing it (in 10 ms, 0: always hold)
+  unsigned char var_jitter;           // Random variation of each half step (in % of a half step, 0: none)
+  unsigned char var_drift;            // Slow variation of the cadence (in %, 0: none)
+  unsigned char var_fatigue;          // Cadence faster at the start and slower at the end of a session (in %, 0: none)
+  unsigned char gait_replay;          // Replay the recorded gait instead of half steps (0: no, 1: yes)
+  unsigned char batt_low;             // Battery voltage to warn (in 100 mV, 0 or 255: no battery monitor)
+  unsigned char batt_off;             // Battery voltage to save the session and sleep (in 100 mV, 0 or 255: never)
+  unsigned char enc_accel;            // Encoder acceleration on fast turns (0: none)
+  unsigned char disp_bright;          // Display brightness (1 to 16)
+  unsigned char disp_dim;             // Display brightness after some time without user interaction (0: no dimming)
+};
+
+namespace registers
+{
+/// Version of the config layout (MyConfig_t), in EEPROM and in config images.
+/// A new layout must convert the config of the previous one in loadConfig().
+const uint8_t configVersion = 9;
+/// EEPROM address of the version (between the battery checkpoint and the programs)
+const unsigned int versionAddress = 0x3f;
+} // namespace registers
@@ -0,0 +1,160 @@
+#pragma once
+
+#include "globals.h"
+
+/// Sessions set by duration ("45 minutes at 160 steps/min") instead of steps.
+///
+/// The step engine is unchanged: the duration is turned into a budget of
+/// steps (movements::stepsRemaining) at the start, and again at the first
+/// step after each change of speed. Each step then takes its time from the
+/// time left, 60000 / speed ms with the remainder carried (no division by
+/// step), so the session stays exact when the speed changes.
+/// The time left is also kept as minutes, seconds and ms for the display,
+/// updated by subtraction at each step.
+namespace duration
+{
+/// Longest session (minutes, 3 digits on the display)
+const uint16_t minutesMax = 999;
+
+/// Is the session set by duration, and its length (minutes and seconds)?
+bool enabled = false;
+uint16_t minutes = 30;
+uint8_t seconds = 0;
+/// Time left (ms), and the same as displayed: minutes, seconds and ms
+uint32_t timeLeft;
+uint16_t leftMinutes;
+uint8_t leftSeconds;
+uint16_t leftMs;
+/// Speed of the budget and duration of a step at this speed: ms, remainder (1/speed ms) and its accumulator
+unsigned char budgetSpeed;
+uint16_t stepMs;
+uint8_t stepRest;
+uint8_t stepError;
+
+/// Reset the time left to the length of the session
+void restart()
+{
+  timeLeft = (uint32_t)minutes * 60000UL + seconds * 1000UL;
+  leftMinutes = minutes;
+  leftSeconds = seconds;
+  leftMs = 0;
+}
+
+/// Set the session by duration (minutes > 0, whole minutes) or by steps (0). Also resets the time left.
+void setMinutes(uint16_t value)
+{
+  enabled = (value > 0);
+  if (enabled)
+  {
+    minutes = (value > minutesMax) ? minutesMax : value;
+    seconds = 0;
+  }
+  restart();
+}
+
+/// Set the session by duration (with its last length) or by steps. Also resets the time left.
+void enable(bool on)
+{
+  enabled = on;
+  restart();
+}
+
+/// Budget of steps for the time left at the actual speed (at a change of speed only)
+void setBudget()
+{
+  budgetSpeed = movements::speed;
+  stepMs = 60000U / budgetSpeed;
+  stepRest = 60000U % budgetSpeed;
+  stepError = 0;
+  // timeLeft * speed / 60000 rounded, without 32-bit overflow
+  movements::stepsRemaining = (timeLeft / 60000UL) * budgetSpeed
+                            + ((timeLeft % 60000UL) * budgetSpeed + 30000UL) / 60000UL;
+}
+
+/// Start a session (from SetSteps or AdjustSteps)
+void start()
+{
+  if (!enabled)
+  {
+    return;
+  }
+  restart();
+  setBudget();
+}
+
+/// Take the time of a step from the time left
+void consume(uint16_t ms)
+{
+  if (ms > timeLeft)
+  {
+    ms = timeLeft;
+  }
+  timeLeft -= ms;
+  while (ms > leftMs)
+  { // Borrow a second
+    ms -= leftMs + 1;
+    leftMs = 999;
+    if (leftSeconds > 0)
+    {
+      leftSeconds--;
+    }
+    else
+    {
+      leftSeconds = 59;
+      leftMinutes--;
+    }
+  }
+  leftMs -= ms;
+}
+
+/// Called by movements at each foot down, before the step is counted
+void onFootDown()
+{
+  if (!enabled)
+  {
+    return;
+  }
+  if (movements::speed != budgetSpeed)
+  {
+    setBudget();
+    if (movements::stepsRemaining == 0)
+    { // This step is done anyway
+      movements::stepsRemaining = 1;
+    }
+  }
+  if (movements::stepsRemaining <= 1)
+  { // Last step of the budget: no time left
+    timeLeft = 0;
+    leftMinutes = 0;
+    leftSeconds = 0;
+    leftMs = 0;
+    return;
+  }
+  uint16_t ms = stepMs;
+  stepError += stepRest;
+  if (stepError >= budgetSpeed)
+  {
+    stepError -= budgetSpeed;
+    ms++;
+  }
+  consume(ms);
+}
+
+/// Change the length of the session by some units of the digit at `position` on the display (MMMSS):
+/// 1 s, 10 s, 1, 10 or 100 minutes. Returns false if limited (1 to 999 minutes).
+bool adjust(int rot, uint8_t position)
+{
+  long rank = (position == 0) ? 1 : ((position == 1) ? 10 : 60);
+  for (uint8_t p = 2; p < position; p++)
+  {
+    rank *= 10;
+  }
+  long value = (long)minutes * 60 + seconds + rot * rank;
+  bool limited = (value < 60) || (value > minutesMax * 60L);
+  value = (value < 60) ? 60 : ((value > minutesMax * 60L) ? minutesMax * 60L : value);
+  minutes = value / 60;
+  seconds = value % 60;
+  restart();
+  return !limited;
+}
+} // namespace duration
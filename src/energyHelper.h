@@ -0,0 +1,99 @@
+#pragma once
+
+#include "globals.h"
+
+/// Energy accounting: cheap counters of where the time (and the current) goes.
+///
+/// The main loop adds the ms elapsed since its last call to the counter of
+/// the actual state, and to the counters of the loads that are on: servo
+/// attached, display (weighted by its brightness: ms at full brightness) and
+/// buzzer. The clicks of the buzzer are too short to be seen by the main
+/// loop and are counted by buzzer::clicCount. millis() stops while sleeping:
+/// PowerOff only counts the time awake.
+/// The counters are read by the serial command `E`; energy.py turns them
+/// into mAh with the current of each load.
+namespace energy
+{
+/// Number of states (PowerOff is the first counter)
+const uint8_t stateCount = stateMachine::States::EditConfig - stateMachine::States::PowerOff + 1;
+/// Duration of a click of the buzzer (ms, see buzzer::clicBuzzer())
+const uint8_t clicMs = 2;
+
+/// Time spent in each state (ms), from PowerOff
+uint32_t stateMs[stateCount];
+/// Time the servo was attached, the display on (at full brightness) and the buzzer on (ms)
+uint32_t servoMs;
+uint32_t displayMs;
+uint32_t buzzerMs;
+/// Display on-time not counted yet (1/BRIGHTNESS_MAX ms)
+uint8_t displayRest;
+/// Steps done
+uint32_t steps;
+/// Time of the last update
+tick_t countedAt;
+
+/// Start counting from now
+void resetEnergy()
+{
+  memset(stateMs, 0, sizeof(stateMs));
+  servoMs = 0;
+  displayMs = 0;
+  buzzerMs = 0;
+  displayRest = 0;
+  steps = 0;
+  buzzer::clicCount = 0;
+  countedAt = ticks();
+}
+
+/// Called by movements at each foot down
+void onFootDown()
+{
+  steps++;
+}
+
+/// Count the time elapsed since the last call. Must be called from the main loop.
+void pollEnergy()
+{
+  tick_t now = ticks();
+  tick_t elapsed = ticksSince(countedAt, now);
+  if (elapsed == 0)
+  {
+    return;
+  }
+  countedAt = now;
+  stateMs[stateMachine::state - stateMachine::States::PowerOff] += elapsed;
+  if (movements::myservo.attached())
+  {
+    servoMs += elapsed;
+  }
+  if (userinterface::disp.isDisplay())
+  {
+    uint32_t on = elapsed * userinterface::disp.getBrightness() + displayRest;
+    displayMs += on / BRIGHTNESS_MAX;
+    displayRest = on % BRIGHTNESS_MAX;
+  }
+  if (digitalRead(board::pinBuzzer))
+  {
+    buzzerMs += elapsed;
+  }
+}
+
+/// Send the counters: ms in each state (from PowerOff), servo, display, buzzer (ms) and steps
+void sendEnergy()
+{
+  Serial.print("OK");
+  for (uint8_t i = 0; i < stateCount; i++)
+  {
+    Serial.print(' ');
+    Serial.print(stateMs[i]);
+  }
+  Serial.print(' ');
+  Serial.print(servoMs);
+  Serial.print(' ');
+  Serial.print(displayMs);
+  Serial.print(' ');
+  Serial.print(buzzerMs + (uint32_t)buzzer::clicCount * clicMs);
+  Serial.print(' ');
+  Serial.println(steps);
+}
+} // namespace energy
@@ -1,11 +1,93 @@
 #pragma once
 
 #include <Arduino.h>
+#include <EEPROM.h>
+#include "board.h"
+#include "configLayout.h"
 
 #define BUTTON_PRESSED (userinterface::encbtn.isPressed())
 #define BUTTON_RELEASED (userinterface::encbtn.isReleased())
 #define BUTTON_LONG_PRESSED (userinterface::encbtn.getPressedDuration() > userinterface::longPressDelay)
-#define USER_INTERACTION_DONE userinterface::lastUserInteractionAt = millis();
-#define LAST_USER_INTERACTION_DELAY (millis() - userinterface::lastUserInteractionAt)
+#define BUTTON_CONFIG_PRESSED (userinterface::encbtn.getPressedDuration() > 3 * userinterface::longPressDelay)
+#define USER_INTERACTION_DONE userinterface::lastUserInteractionAt = ticks();
+#define LAST_USER_INTERACTION_DELAY ticksSince(userinterface::lastUserInteractionAt, ticks())
 #define BLANK_SCREEN userinterface::disp.noDisplay();
 #define UNBLANK_SCREEN userinterface::disp.display();
+
+/// Time in ms (millis()). It wraps every 49.7 days: two ticks are only compared
+/// through their difference, which is right up to 24.8 days apart.
+typedef uint32_t tick_t;
+
+/// Actual time
+inline tick_t ticks()
+{
+  return millis();
+}
+
+/// Time elapsed from `since` to `now`
+inline tick_t ticksSince(tick_t since, tick_t now)
+{
+  return now - since;
+}
+
+/// Time from `now` to `at` (negative once `at` is passed)
+inline int32_t ticksUntil(tick_t at, tick_t now)
+{
+  return (int32_t)(at - now);
+}
+
+extern MyConfig_t config;
+extern const MyConfig_t defaultConfig;
+extern unsigned long powerOffDelay;
+extern unsigned long setTimeout;
+void applyConfig();
+
+/// Declarations used before their helper is included
+namespace movements
+{
+extern unsigned long stepsRemaining;
+extern unsigned char speed;
+} // namespace movements
+
+namespace sync
+{
+void onFootDown();
+} // namespace sync
+
+namespace program
+{
+void onFootDown();
+} // namespace program
+
+namespace battery
+{
+void onFootDown();
+bool restoreCheckpoint();
+} // namespace battery
+
+namespace energy
+{
+void onFootDown();
+} // namespace energy
+
+namespace steplog
+{
+void onFootDown();
+} // namespace steplog
+
+namespace stateMachine
+{
+/// List of states
+enum States : int8_t {
+  PowerOff = -1,
+  Init = 0,
+  SetSteps,
+  AdjustSteps,
+  Emulate,
+  Paused,
+  ChangeSpeed,
+  Finished,
+  EditConfig
+};
+extern States state;
+} // namespace stateMachine
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "globals.h"
+
+/// Recorder of the inputs, to replay them on the host (simulator --input).
+///
+/// The edges of the button, the detents of the encoder (as seen by their
+/// interrupts, before debounce) and the changes of state are written in a
+/// RAM ring as a compact binary trace. Each event is one byte (its type and
+/// value) followed by the time since the previous event (ms, 7 bits by byte,
+/// low bits first, bit 7 set when more bytes follow). The first event is
+/// timed from power up (millis() = 0).
+/// The ring is drained by the serial command `J` (hexadecimal). When it is
+/// full, the new events are dropped and a Lost event is written once there
+/// is room again: the time of the next events stays right.
+namespace inputtrace
+{
+/// Size of the ring (bytes)
+const uint8_t ringSize = 128;
+/// Most bytes sent by answer
+const uint8_t drainMax = 24;
+/// Longest event (type and 32-bit time)
+const uint8_t eventMax = 6;
+
+/// Types of events (2 high bits of the first byte)
+enum Events : uint8_t {
+  Button = 0x00,    // Bit 0: pressed
+  Encoder = 0x40,   // Bit 0: clockwise
+  State = 0x80,     // Bits 0 to 3: state + 1
+  Lost = 0xc0       // Events dropped before this one
+};
+
+volatile uint8_t ring[ringSize];
+volatile uint8_t head = 0;
+volatile uint8_t tail = 0;
+volatile uint8_t used = 0;
+/// Time of the last event written
+volatile tick_t recordedAt = 0;
+/// Were events dropped since the last one written?
+volatile bool lost = false;
+
+/// Write an event (interrupts disabled)
+void push(uint8_t event)
+{
+  if (!features::inputTrace)
+  {
+    return;
+  }
+  if (lost)
+  {
+    if (ringSize - used < 2 * eventMax)
+    {
+      return;
+    }
+    lost = false;
+    push(Events::Lost);
+  }
+  if (ringSize - used < eventMax)
+  {
+    lost = true;
+    return;
+  }
+  tick_t now = ticks();
+  tick_t delta = ticksSince(recordedAt, now);
+  recordedAt = now;
+  ring[head] = event;
+  head = (head + 1) % ringSize;
+  used++;
+  do
+  {
+    ring[head] = (delta & 0x7f) | ((delta > 0x7f) ? 0x80 : 0);
+    head = (head + 1) % ringSize;
+    used++;
+    delta >>= 7;
+  } while (delta > 0);
+}
+
+/// Edge of the button (INT0 interrupt)
+inline void onButton(bool pressed)
+{
+  push(Events::Button | pressed);
+}
+
+/// Detent of the encoder (INT1 interrupt)
+inline void onEncoder(bool clockwise)
+{
+  push(Events::Encoder | clockwise);
+}
+
+/// Change of state (main loop)
+void onState(int8_t state)
+{
+  noInterrupts();
+  push(Events::State | ((state + 1) & 0x0f));
+  interrupts();
+}
+
+/// Send and drop the oldest bytes of the trace (hexadecimal)
+void sendTrace()
+{
+  const char hex[] = "0123456789abcdef";
+  Serial.print("OK");
+  uint8_t n = (used > drainMax) ? drainMax : used;
+  if (n > 0)
+  {
+    Serial.print(' ');
+  }
+  for (uint8_t i = 0; i < n; i++)
+  {
+    uint8_t b = ring[tail];
+    Serial.print(hex[b >> 4]);
+    Serial.print(hex[b & 0x0f]);
+    tail = (tail + 1) % ringSize;
+    noInterrupts();
+    used--;
+    interrupts();
+  }
+  Serial.println();
+}
+} // namespace inputtrace
@@ -1,12 +1,25 @@
 
 #include "globals.h"
-#include "stateMachineHelper.h"
+#include "builtInLedHelper.h"
 #include "buzzerHelper.h"
-#include "powerHelper.h"
+#include "inputTraceHelper.h"
+#include "durationHelper.h"
 #include "userinterfaceHelper.h"
+#include "cadenceHelper.h"
 #include "movementsHelper.h"
-#include "builtInLedHelper.h"
-#include <EEPROM.h>
+#include "programHelper.h"
+#include "powerHelper.h"
+#include "memoryHelper.h"
+#include "registersHelper.h"
+#include "stateMachineHelper.h"
+#include "batteryHelper.h"
+#include "energyHelper.h"
+#include "stepLogHelper.h"
+#include "syncHelper.h"
+#include "serialHelper.h"
+#ifdef BENCHMARK
+#include "benchmarkHelper.h"
+#endif
 
 
 // #define DEBUG_SER
@@ -14,51 +27,53 @@
 
 unsigned long powerOffDelay;          // Delay before to switch off
 unsigned long setTimeout;             // Delay before leaving set mode (timeout)
-
-struct MyConfig_t {
-  unsigned char pos_stepdown;         // Servo motor position when foot is down
-  unsigned char pos_stepup;           // Servo motor position when foot is up
-  unsigned int  steps_init;           // Number of steps by default (at startup)
-  unsigned int  steps_min;            // Number of steps at minimum
-  unsigned int  steps_max;            // Number of steps at maximum
-  unsigned char speed_init;           // Default speed (at startup) (steps by minute)
-  unsigned char speed_min;            // Lowest speed (steps by minute)
-  unsigned char speed_max;            // Highest speed (steps by minute)
-  unsigned char step_ratio;           // Step ratio (step up/down)
-  unsigned char delay_longpress;      // Delay for a long press (previously LONG_PRESS) but in 10th of seconds
-  unsigned char delay_set;            // Delay to exit set mode (previously DIGIT_TIMEOUT) but in 10th of seconds
-  unsigned char delay_off;            // Delay before displaying OFF message (in seconds)
-  unsigned char delay_offmsg;         // Delay before auto power off after OFF message (in 10th of seconds)
-} config;
+MyConfig_t config;
 
 const MyConfig_t defaultConfig = {
   22,         // 0x00: 0x16
   130,        // 0x01: 0x82
-  1000,       // 0x02: 0xe8 0x03 [232 3]
-  10,         // 0x04: 0x0a 0x00 [10 0]
-  20000,      // 0x06: 0x20 0x4e [32 78]
-  100,        // 0x08: 0x64
-  16,         // 0x09: 0x10
-  255,        // 0x0a: 0xff
-  50,         // 0x0b: 0x32
-  10,         // 0x0c: 0x0a (1 second)
-  15,         // 0x0d: 0x0f (1.5 second)
-  60,         // 0x0e: 0x3c (60 seconds)
-  50          // 0x0f: 0x32 (5 seconds)
+  1000,       // 0x02: 0xe8 0x03 0x00 0x00 [232 3 0 0]
+  10,         // 0x06: 0x0a 0x00 0x00 0x00 [10 0 0 0]
+  1000000,    // 0x0a: 0x40 0x42 0x0f 0x00 [64 66 15 0]
+  100,        // 0x0e: 0x64
+  16,         // 0x0f: 0x10
+  255,        // 0x10: 0xff
+  50,         // 0x11: 0x32
+  10,         // 0x12: 0x0a (1 second)
+  15,         // 0x13: 0x0f (1.5 second)
+  60,         // 0x14: 0x3c (60 seconds)
+  50,         // 0x15: 0x32 (5 seconds)
+  0,          // 0x16: 0x00 (no synchronization)
+  25,         // 0x17: 0x19 (250 ms)
+  0,          // 0x18: 0x00 (no jitter)
+  0,          // 0x19: 0x00 (no drift)
+  0,          // 0x1a: 0x00 (no fatigue)
+  0,          // 0x1b: 0x00 (half steps)
+  0,          // 0x1c: 0x00 (no battery monitor)
+  0,          // 0x1d: 0x00 (no battery monitor)
+  4,          // 0x1e: 0x04
+  16,         // 0x1f: 0x10 (full brightness)
+  4           // 0x20: 0x04 (quarter brightness when idle)
 };
 
+/// Update values derived from config
+void applyConfig() {
+  userinterface::longPressDelay = (unsigned long)config.delay_longpress * 100UL;
+  powerOffDelay = (unsigned long)config.delay_off * 1000UL;
+  setTimeout = (unsigned long)config.delay_set * 100UL;
+}
+
 /*****************************************************************************
  * Initialisation ------------------------------------------------------------
  *****************************************************************************/
 void setup() {
-  const static unsigned char configSize = sizeof(MyConfig_t) - 1;
-#ifdef DEBUG_SER
-  Serial.begin(9600);
-#endif
+  serialcmd::setupSerialCommands();
   power::setupPower();
   builtinled::setupBuiltInLed();
   buzzer::setupBuzzer();
   userinterface::setupUI();
+  battery::setupBattery();
+  steplog::setupStepLog();
 
   powerOffDelay = 60000;  // 60 secondes
   
@@ -67,7 +82,7 @@ void setup() {
   {
     buzzer::testBuzzer(200UL);
     userinterface::refreshUI();
-    if (BUTTON_LONG_PRESSED) //  && BUTTON_PRESSED ?
+    if (BUTTON_PRESSED && BUTTON_LONG_PRESSED)
     {
       if (!changeConfig)
       {
@@ -79,72 +94,21 @@ void setup() {
     }
   }
 
+  registers::loadConfig();
   // If button stay pressed long enough, switch to configuration mode
   if (changeConfig)
   {
-    unsigned char address = 0;
-    bool addressSelected = true;
-    unsigned char value = EEPROM.read(address);
-    userinterface::disp.write(address, value, true);
-    movements::setMovements(value);
-    userinterface::disp.setCursor(3);
-    userinterface::disp.cursor();
-    movements::powerOnMovements();
-    while (changeConfig)
+    registers::startEditor();
+    while (registers::edit())
     {
       userinterface::refreshUI();
-      if (BUTTON_RELEASED)
-      {
-        if (BUTTON_LONG_PRESSED)
-        {
-          EEPROM.update(address, value);
-          changeConfig = false;
-        }
-        else
-        {
-          addressSelected = !addressSelected;
-          userinterface::disp.setCursor(addressSelected?3:0);
-        }
-      }
-      if (userinterface::isEncoderRotated())
-      {
-        if (addressSelected)
-        {
-          EEPROM.update(address, value);
-          if (userinterface::encoderChangeValue(&address, configSize))
-          {
-            buzzer::clicBuzzer();
-          }
-          value = EEPROM.read(address);
-        }
-        else
-        {
-          if (userinterface::encoderChangeValue(&value, 255))
-          {
-            buzzer::clicBuzzer();
-          }
-        }
-        userinterface::disp.write(address, value, true);
-        switch (address)
-        {
-          case 0:
-          case 1:
-            movements::setMovements(value);
-            break;
-          default:
-            break;
-        }
-      }
-    } // while changeConfig
-    movements::powerOffMovements();
+    }
   } // if changeConfig
 
-  EEPROM.get(0, config);
   movements::stepsRemaining = config.steps_init;
   movements::speed = config.speed_init;
-  userinterface::longPressDelay = (unsigned long)config.delay_longpress * 100UL;
-  powerOffDelay = (unsigned long)config.delay_off * 1000UL;
-  setTimeout = (unsigned long)config.delay_set * 100UL;
+  applyConfig();
+  registers::setupRegisters();
 #ifdef DEBUG_SER
   Serial.println("Steps: " + String(movements::stepsRemaining));
   Serial.println("Speed: " + String(movements::speed) + " steps/min");
@@ -157,13 +121,24 @@ void setup() {
   userinterface::displaySteps();
   userinterface::resetEncoder();
   stateMachine::setupStateMachine();
+  energy::resetEnergy();
 }
 
 /*****************************************************************************
  * Main loop -----------------------------------------------------------------
  *****************************************************************************/
 void loop() {
+#ifdef BENCHMARK
+  benchmark::run();
+  while (true);
+#endif
   userinterface::refreshUI();
+  serialcmd::pollSerialCommands();
+  sync::pollSync();
+  battery::pollBattery();
+  registers::pollRegisters();
+  energy::pollEnergy();
+  steplog::pollStepLog();
   stateMachine::doState();
   userinterface::resetEncoderPosition();
 }
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "globals.h"
+
+/// Methods to watch the SRAM usage at runtime.
+///
+/// At reset, the free SRAM between the end of the variables and the top of
+/// the stack is painted with a known value. The stack high-water mark is
+/// then the part of this area that was never overwritten.
+/// The values are readable as read-only addresses following MyConfig_t
+/// (config mode and serial `R` command), low byte first.
+namespace memory
+{
+/// Value used to paint the free SRAM
+const uint8_t paintColor = 0xc5;
+
+/// Read-only addresses, following the config
+enum Probes : uint8_t {
+  StackUnusedLow = 0,   // Bytes never reached by the stack (low byte)
+  StackUnusedHigh,      // Bytes never reached by the stack (high byte)
+  FreeMemoryLow,        // Bytes actually free between heap and stack (low byte)
+  FreeMemoryHigh,       // Bytes actually free between heap and stack (high byte)
+  ProbeCount
+};
+
+/// First address of the probes
+const uint8_t firstProbeAddress = sizeof(MyConfig_t);
+
+#ifdef __AVR__
+extern "C" {
+extern uint8_t _end;            // End of variables (.bss and .noinit)
+extern uint8_t __stack;         // Top of SRAM
+extern uint8_t __heap_start;    // Start of heap
+extern void *__brkval;          // Top of heap (0 if heap is not used)
+}
+
+/// Paint the free SRAM (called before main, the stack is still empty)
+void paintStack() __attribute__((naked, used, section(".init3")));
+void paintStack()
+{
+    uint8_t *p = &_end;
+    while (p <= &__stack)
+    {
+        *p = paintColor;
+        p++;
+    }
+}
+
+/// Number of bytes never used by the stack (and heap) since reset
+uint16_t stackUnused()
+{
+    const uint8_t *p = (__brkval == 0) ? &_end : (const uint8_t *)__brkval;
+    uint16_t count = 0;
+    while ((p <= &__stack) && (*p == paintColor))
+    {
+        p++;
+        count++;
+    }
+    return count;
+}
+
+/// Number of bytes actually free between heap and stack
+uint16_t freeMemory()
+{
+    uint8_t top;
+    const uint8_t *heapEnd = (__brkval == 0) ? &__heap_start : (const uint8_t *)__brkval;
+    return (uint16_t)(&top - heapEnd);
+}
+#else
+uint16_t stackUnused()
+{
+    return 0;
+}
+
+uint16_t freeMemory()
+{
+    return 0;
+}
+#endif
+
+/// Is this address a probe (rather than a config byte)?
+bool isProbe(uint8_t address)
+{
+    return (address >= firstProbeAddress) && (address < firstProbeAddress + ProbeCount);
+}
+
+/// Read a probe
+uint8_t readProbe(uint8_t address)
+{
+    switch (address - firstProbeAddress)
+    {
+        case StackUnusedLow:
+            return stackUnused() & 0xff;
+        case StackUnusedHigh:
+            return stackUnused() >> 8;
+        case FreeMemoryLow:
+            return freeMemory() & 0xff;
+        case FreeMemoryHigh:
+            return freeMemory() >> 8;
+        default:
+            return 0;
+    }
+}
+} // namespace memory
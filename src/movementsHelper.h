@@ -1,20 +1,62 @@
 #pragma once
 
 #include "globals.h"
+#include "gaitTrace.h"
 #include <Servo.h>
 
 /// Methods to make movements to emulate walk/run.
 namespace movements
 {
 Servo myservo;
-/// Define PIN used to connect a servo (only 9 or 10 is supported)
-const uint8_t pinServo = 10; // Only 9 or 10 is supported
 
 /// Number of steps remaining
-unsigned int stepsRemaining;
+unsigned long stepsRemaining;
 // Actual speed (steps by second)
 unsigned char speed;
 
+/// Time of the next half step
+tick_t nextStepAt = 0;
+/// Is the foot up (last half step)?
+bool footUp = false;
+/// Is a walk in progress?
+bool walking = false;
+
+/// Time between re-attaching the servo and the next half step (ms): 2 frames of PWM
+const unsigned long rearmLead = 40;
+/// Shortest release worth detaching the servo (ms)
+const unsigned long minRelease = 100;
+/// Is the servo released (no pulses) while waiting for the next half step?
+bool gated = false;
+/// Time of the last half step
+tick_t lastStepAt = 0;
+/// Are the steps frozen by a press of the button (emergency stop), and since when?
+volatile bool frozen = false;
+volatile tick_t frozenAt;
+
+/// Replay of the recorded gait (gaitTrace.h, made by gaittrace.py): decoder state
+/// Next nibble of the trace
+unsigned int traceIndex;
+/// Actual position (0: foot down, 255: foot up) and last delta
+uint8_t tracePosition;
+int8_t traceDelta;
+/// Position in the trace (frames, 16.16), frames by servo frame at the speed it was computed for
+uint32_t tracePhase;
+uint32_t traceRate;
+unsigned char traceSpeed = 0;
+/// Most frames of the trace skipped by servo frame (fast steps from a slow trace)
+const uint8_t traceSkipMax = 8;
+
+/// Trace codes (nibbles, see gaittrace.py)
+enum TraceCodes : uint8_t {
+  SmallMax = 6,   // 0 to 12: change of the delta from -6 to 6
+  Up = 0xd,       // then m: change of the delta 7 + m
+  Down = 0xe,     // then m: change of the delta -(7 + m)
+  Control = 0xf,  // then one of:
+  Strike = 0x0,   //   the next frame is a foot strike
+  Absolute = 0x1, //   then 2 nibbles: position of the frame
+  End = 0xf       //   back to the first frame
+};
+
 /// Setup movements
 void setupMovements()
 {
@@ -25,17 +67,35 @@ void setupMovements()
 void powerOnMovements()
 {
     // timer1 (TCCR1) used by servo
-    myservo.attach(pinServo);
+    myservo.attach(board::pinServo);
 }
 
 /// Power OFF motor/servo
 void powerOffMovements()
 {
+    gated = false;
     if (myservo.attached())
     {
         myservo.detach();
     }
-    digitalWrite(pinServo, LOW);
+    digitalWrite(board::pinServo, LOW);
+}
+
+/// Stop walking (the next walk() starts again)
+void stopMovements()
+{
+    walking = false;
+    powerOffMovements();
+}
+
+/// Freeze the steps at once: the servo stays at its last position (button interrupt)
+void freeze()
+{
+    if (!frozen)
+    {
+        frozenAt = ticks();
+        frozen = true;
+    }
 }
 
 /// Setup the position of the servo
@@ -44,29 +104,199 @@ void setMovements(uint8_t value)
     myservo.write(value);
 }
 
+/// Release the servo while it holds its position between two half steps.
+/// The servo is released once it had time to reach its position
+/// (config.servo_settle) and re-attached rearmLead ms before the next half step.
+void gateServo(tick_t now)
+{
+  if (config.servo_settle == 0)
+  {
+    return;
+  }
+  unsigned long settle = (unsigned long)config.servo_settle * 10UL;
+  if (gated)
+  {
+    if (ticksUntil(nextStepAt, now) <= (int32_t)rearmLead)
+    {
+      myservo.attach(board::pinServo);
+      gated = false;
+    }
+  }
+  else if ((ticksSince(lastStepAt, now) >= settle)
+           && (ticksUntil(nextStepAt, now) > (int32_t)(rearmLead + minRelease)))
+  {
+    myservo.detach();
+    digitalWrite(board::pinServo, LOW);
+    gated = true;
+  }
+}
+
+/// Count a step (the foot is down)
+void countStep()
+{
+  steplog::onFootDown();
+  sync::onFootDown();
+  cadence::onFootDown();
+  battery::onFootDown();
+  energy::onFootDown();
+  duration::onFootDown();
+  stepsRemaining--;
+  program::onFootDown();
+  if (stepsRemaining == 0)
+  {
+    walking = false;
+    powerOffMovements();
+  }
+  if (stateMachine::state == stateMachine::States::Emulate)
+  {
+    userinterface::displaySteps();
+  }
+}
+
+/// Restart the recorded gait from its first frame
+void rewindTrace()
+{
+  traceIndex = 0;
+  tracePosition = gaitStart;
+  traceDelta = 0;
+}
+
+/// Next nibble of the trace (high nibble of each byte first)
+uint8_t nextNibble()
+{
+  uint8_t code = pgm_read_byte(&gaitTrace[traceIndex >> 1]);
+  code = (traceIndex & 1) ? (code & 0x0f) : (code >> 4);
+  traceIndex++;
+  return code;
+}
+
+/// Decode the next frame of the trace. Returns true on a foot strike.
+bool decodeFrame()
+{
+  bool strike = false;
+  while (true)
+  {
+    uint8_t code = nextNibble();
+    if (code <= 2 * TraceCodes::SmallMax)
+    {
+      traceDelta += (int8_t)code - TraceCodes::SmallMax;
+    }
+    else if (code == TraceCodes::Up)
+    {
+      traceDelta += TraceCodes::SmallMax + 1 + nextNibble();
+    }
+    else if (code == TraceCodes::Down)
+    {
+      traceDelta -= TraceCodes::SmallMax + 1 + nextNibble();
+    }
+    else
+    {
+      code = nextNibble();
+      if (code == TraceCodes::Strike)
+      {
+        strike = true;
+        continue;
+      }
+      if (code == TraceCodes::End)
+      { // The first frame is a foot strike
+        rewindTrace();
+        return true;
+      }
+      // Absolute: the delta is the jump
+      uint8_t position = nextNibble() << 4;
+      position |= nextNibble();
+      traceDelta = (int8_t)(position - tracePosition);
+    }
+    tracePosition += traceDelta;
+    return strike;
+  }
+}
+
+/// Replay the recorded gait: one servo position by servo frame (nextStepAt is the next frame)
+void replayFrame(tick_t now)
+{
+  if (ticksUntil(nextStepAt, now) < -(int32_t)(gaitFrameMs * traceSkipMax))
+  { // Paused or busy main loop: no catch up
+    nextStepAt = now;
+  }
+  nextStepAt += gaitFrameMs;
+  if (speed != traceSpeed)
+  { // Trace frames by servo frame: gaitFramesPerStep * gaitFrameMs / (60000 / speed)
+    traceSpeed = speed;
+    traceRate = (uint32_t)(((uint64_t)gaitFramesPerStep * gaitFrameMs * speed) / 60000UL);
+    if (traceRate > ((uint32_t)traceSkipMax << 16))
+    {
+      traceRate = (uint32_t)traceSkipMax << 16;
+    }
+  }
+  tracePhase += traceRate;
+  bool strike = false;
+  while (tracePhase >= 0x10000UL)
+  {
+    tracePhase -= 0x10000UL;
+    strike |= decodeFrame();
+  }
+  int stroke = (int)config.pos_stepup - (int)config.pos_stepdown;
+  // stroke * position / 255 without division
+  myservo.write(config.pos_stepdown + (int)(((long)stroke * tracePosition * 257L + 32768L) >> 16));
+  footUp = tracePosition >= 128;
+  userinterface::disp.writeDot(DOT_RESERVED, footUp);
+  if (strike)
+  {
+    countStep();
+  }
+}
+
 /// Emulate walk movements
 bool walk()
 {
-  static unsigned long nextStepAt = 0;
-  static bool footUp = false;
-  static bool walking = false;
   if (stepsRemaining == 0)
   {
     return true;
   }
   else
   {
-    unsigned long now = millis();
+    tick_t now = ticks();
+    if (frozen)
+    {
+      // The state machine pauses or stops once the press is classified.
+      // A glitch on the button line (no press seen after debounce) goes on, the steps shifted.
+      if (BUTTON_PRESSED || !digitalRead(board::pinEncS) || (ticksSince(frozenAt, now) <= userinterface::debounceTime))
+      {
+        return false;
+      }
+      tick_t held = ticksSince(frozenAt, now);
+      nextStepAt += held;
+      cadence::shift(held);
+      frozen = false;
+    }
     if (!walking)
     { // Start walking
       walking = true;
       powerOnMovements();
       footUp = false;
-      nextStepAt = 0;
+      nextStepAt = now;
+      cadence::start(now, stepsRemaining);
+      rewindTrace();
+      tracePhase = 0;
     }
-    if (int(nextStepAt - now) < 0)
+    if (features::gaitReplay && config.gait_replay)
     {
-      nextStepAt = now + (unsigned long)(30000U / (unsigned int)speed); // 60000 / 2
+      if (ticksUntil(nextStepAt, now) <= 0)
+      {
+        replayFrame(now);
+      }
+    }
+    else if (ticksUntil(nextStepAt, now) < 0)
+    {
+      if (gated)
+      { // Late re-arm (main loop was busy)
+        myservo.attach(board::pinServo);
+        gated = false;
+      }
+      lastStepAt = now;
+      // From the grid, not from now: the mean speed does not depend on the main loop latency
+      nextStepAt = cadence::nextHalfStep(now);
       footUp = !footUp;
       userinterface::disp.writeDot(DOT_RESERVED, footUp);
       if (footUp)
@@ -76,20 +306,47 @@ bool walk()
       else
       {
         myservo.write(config.pos_stepdown);
-        stepsRemaining--;
-        if (stepsRemaining == 0)
-        {
-          walking = false;
-          powerOffMovements();
-        }
-        if (stateMachine::state == stateMachine::States::Emulate)
-        {
-          userinterface::displaySteps();
-        }
+        countStep();
       }
     }
+    else
+    {
+      gateServo(now);
+    }
   }
   return false;
 }
 
+/// Wait some time before the next half step
+void delaySteps(unsigned long ms)
+{
+  nextStepAt = ticks() + ms;
+  cadence::restartAt(nextStepAt);
+}
+
+/// Align the steps on a foot down of another unit that happened `ago` ms before
+void syncFootDown(unsigned long ago)
+{
+  if (!walking || (features::gaitReplay && config.gait_replay))
+  { // A recorded gait keeps its own rhythm
+    return;
+  }
+  unsigned long halfPeriod = cadence::halfPeriod;
+  tick_t otherDownAt = ticks() - ago;
+  tick_t nextDownAt = footUp ? nextStepAt : nextStepAt + halfPeriod;
+  // Phase error in [-halfPeriod, halfPeriod[ (the next foot down may be before the other one)
+  long error = ticksUntil(nextDownAt, otherDownAt) % (long)(2 * halfPeriod);
+  if (error >= (long)halfPeriod)
+  {
+    error -= 2 * halfPeriod;
+  }
+  else if (error < -(long)halfPeriod)
+  {
+    error += 2 * halfPeriod;
+  }
+  // Correct half of the error at each beacon to absorb the jitter
+  nextStepAt -= error / 2;
+  cadence::shift(-error / 2);
+}
+
 } // namespace movements
@@ -7,27 +7,24 @@
 /// Methods to control power
 namespace power
 {
-const uint8_t pinPower = 12;
-const uint8_t pinWakeUp = 2; // INT0 = ENCS
-
 ///  Initialize power
 void setupPower()
 {
-      pinMode(pinPower, OUTPUT);
-      digitalWrite(pinPower, HIGH);
+      pinMode(board::pinPower, OUTPUT);
+      digitalWrite(board::pinPower, HIGH);
 }
 
 /// Power ON the external components
 void powerOn()
 {
-    digitalWrite(pinPower, HIGH);
+    digitalWrite(board::pinPower, HIGH);
     delay(10);
 }
 
 /// Power OFF the external components
 void powerOff()
 {
-    digitalWrite(pinPower, LOW);
+    digitalWrite(board::pinPower, LOW);
 }
 
 /// Interrupt called at wakeup
@@ -57,7 +54,7 @@ void goToSleepAndWaitWakeUp()
 
     power_all_disable();  // turn off various modules
 
-    // will be called when INT0 (=PIN_ENCS) goes low
+    // will be called when INT0 (=board::pinEncS) goes low
     attachInterrupt(INT0, wakeUpInterrupt, FALLING);
     EIFR = bit (INT0);  // clear flag for interrupt 0 or 1
 
@@ -76,7 +73,7 @@ void goToSleepAndWaitWakeUp()
 
 
     // Here we are sleeping --- Zzzz Zzzz Zzzz Zzzz Zzzz Zzzz Zzzz
-    // Waiting RESET or interrupt on INT0 (pin 2 = PIN_ENCS)
+    // Waiting RESET or interrupt on INT0 (pin 2 = board::pinEncS)
 
 
     builtinled::ledOff();
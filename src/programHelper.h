@@ -0,0 +1,242 @@
+#pragma once
+
+#include "globals.h"
+
+/// Workout programs stored in EEPROM and run segment by segment.
+///
+/// Programs follow each other from programBase, each one ends with End.
+/// The first byte of the free space is 0xff (erased EEPROM).
+/// Instructions (words are little endian):
+///  - End                             0x00
+///  - Segment <steps:16> <speed>      0x01: steps at a constant speed
+///  - Ramp <steps:16> <from> <to>     0x02: steps with a speed going linearly from `from` to `to`
+///  - Pause <seconds:16>              0x03: no step during some time
+///  - Repeat <count>                  0x04: repeat count times up to the matching Loop
+///  - Loop                            0x05
+/// Example: warm-up 500 steps at 80, 10 x (200 at 160 / 100 at 100),
+/// cool-down 200 steps from 100 to 60:
+///   01 f4 01 50  04 0a  01 c8 00 a0  01 64 00 64  05  02 c8 00 64 3c  00
+namespace program
+{
+/// First address of the programs in EEPROM (after the config, with room to grow)
+const unsigned int programBase = 0x40;
+/// Size of the program area
+const unsigned int programSize = 0x400 - programBase;
+/// Maximum number of programs
+const uint8_t programMax = 9;
+/// Maximum depth of Repeat
+const uint8_t repeatDepth = 2;
+
+/// Instructions
+enum Opcodes : uint8_t {
+  End = 0x00,
+  Segment,
+  Ramp,
+  Pause,
+  Repeat,
+  Loop,
+  Erased = 0xff
+};
+
+/// Selected program (0: none, steps are set by hand)
+uint8_t selected = 0;
+/// Is a program running?
+bool running = false;
+/// Address of the next instruction
+unsigned int pc;
+/// Repeat stack: address of the first instruction and remaining count
+unsigned int repeatAt[repeatDepth];
+uint8_t repeatCount[repeatDepth];
+uint8_t repeatLevel;
+/// Actual ramp: remaining speed change, steps and error accumulator (no division by step)
+int rampDelta;
+unsigned int rampSteps;
+unsigned int rampError;
+
+/// Read a 16-bit word in EEPROM
+unsigned int readWord(unsigned int address)
+{
+  return EEPROM.read(address) | ((unsigned int)EEPROM.read(address + 1) << 8);
+}
+
+/// Size of an instruction
+uint8_t instructionSize(uint8_t opcode)
+{
+  switch (opcode)
+  {
+    case Opcodes::Segment:
+      return 4;
+    case Opcodes::Ramp:
+      return 5;
+    case Opcodes::Pause:
+      return 3;
+    case Opcodes::Repeat:
+      return 2;
+    default:
+      return 1;
+  }
+}
+
+/// Address of a program (1 for the first one), or 0 if it does not exist
+unsigned int programAddress(uint8_t number)
+{
+  unsigned int address = programBase;
+  while ((number > 1) && (address < programBase + programSize))
+  {
+    uint8_t opcode = EEPROM.read(address);
+    if (opcode == Opcodes::Erased)
+    {
+      return 0;
+    }
+    address += instructionSize(opcode);
+    if (opcode == Opcodes::End)
+    {
+      number--;
+    }
+  }
+  if ((address >= programBase + programSize) || (EEPROM.read(address) == Opcodes::Erased))
+  {
+    return 0;
+  }
+  return address;
+}
+
+/// Display the selected program: "Pr  n"
+void displayProgram()
+{
+  userinterface::disp.write((unsigned int)selected);
+  userinterface::disp.write(DIGIT_MAX - 1, 0xce); // P
+  userinterface::disp.write(DIGIT_MAX - 2, 0x0a); // r
+}
+
+/// Select the next/previous program (0 is no program)
+void select(int8_t rot)
+{
+  if (!features::programs)
+  {
+    return;
+  }
+  int number = selected + rot;
+  if (number < 0)
+  {
+    number = 0;
+  }
+  while ((number > 0) && ((number > programMax) || (programAddress(number) == 0)))
+  {
+    number--;
+  }
+  selected = number;
+}
+
+/// Load instructions up to the next steps. Returns false at the end of the program.
+bool next()
+{
+  while (pc < programBase + programSize)
+  {
+    uint8_t opcode = EEPROM.read(pc);
+    unsigned int at = pc;
+    pc += instructionSize(opcode);
+    switch (opcode)
+    {
+      case Opcodes::Segment:
+        movements::speed = constrain(EEPROM.read(at + 3), config.speed_min, config.speed_max);
+        movements::stepsRemaining = readWord(at + 1);
+        rampSteps = 0;
+        if (movements::stepsRemaining > 0)
+        {
+          cadence::startCurves(movements::stepsRemaining);
+          return true;
+        }
+        break;
+      case Opcodes::Ramp:
+        movements::speed = constrain(EEPROM.read(at + 3), config.speed_min, config.speed_max);
+        movements::stepsRemaining = readWord(at + 1);
+        rampSteps = movements::stepsRemaining;
+        rampDelta = (int)constrain(EEPROM.read(at + 4), config.speed_min, config.speed_max) - movements::speed;
+        rampError = 0;
+        if (movements::stepsRemaining > 0)
+        {
+          cadence::startCurves(movements::stepsRemaining);
+          return true;
+        }
+        break;
+      case Opcodes::Pause:
+        movements::delaySteps((unsigned long)readWord(at + 1) * 1000UL);
+        break;
+      case Opcodes::Repeat:
+        if ((repeatLevel < repeatDepth) && (EEPROM.read(at + 1) > 0))
+        {
+          repeatAt[repeatLevel] = pc;
+          repeatCount[repeatLevel] = EEPROM.read(at + 1);
+          repeatLevel++;
+        }
+        break;
+      case Opcodes::Loop:
+        if (repeatLevel > 0)
+        {
+          if (--repeatCount[repeatLevel - 1] > 0)
+          {
+            pc = repeatAt[repeatLevel - 1];
+          }
+          else
+          {
+            repeatLevel--;
+          }
+        }
+        break;
+      default: // End or invalid
+        running = false;
+        return false;
+    }
+  }
+  running = false;
+  return false;
+}
+
+/// Start the selected program (nothing if steps are set by hand)
+void start()
+{
+  running = false;
+  if (!features::programs || (selected == 0))
+  {
+    return;
+  }
+  pc = programAddress(selected);
+  if (pc == 0)
+  {
+    selected = 0;
+    return;
+  }
+  repeatLevel = 0;
+  running = true;
+  next();
+}
+
+/// Stop the program
+void stop()
+{
+  running = false;
+}
+
+/// Called by movements at each foot down, after the step is counted
+void onFootDown()
+{
+  if (!features::programs || !running)
+  {
+    return;
+  }
+  if (movements::stepsRemaining == 0)
+  { // Next segment without gap
+    next();
+  }
+  else if (rampSteps > 0)
+  { // Spread rampDelta over rampSteps
+    rampError += abs(rampDelta);
+    while (rampError >= rampSteps)
+    {
+      rampError -= rampSteps;
+      movements::speed += (rampDelta > 0) ? 1 : -1;
+    }
+  }
+}
+} // namespace program
@@ -0,0 +1,345 @@
+#pragma once
+
+#include "globals.h"
+#include <stddef.h>
+
+/// Typed map of the config (MyConfig_t), edited live.
+///
+/// Each field has its offset in MyConfig_t (known at compile time), its size
+/// and its range. Changes are made on the RAM copy (config) and applied at
+/// once; the EEPROM is written back once the config has not changed for
+/// writeBackDelay ms (and before sleeping).
+/// The editor shows the config as bytes (address in hex, value in decimal),
+/// like the power-up config mode. It is also reached from SetSteps by a very
+/// long press (configPressDelay).
+namespace registers
+{
+/// Most steps (the display shows up to 99999 thousands)
+const uint32_t stepsMax = 99999999UL;
+/// Time without change before writing the config in EEPROM (ms)
+const unsigned long writeBackDelay = 2000;
+/// Config of the first firmware (no version): 16-bit step counts, fields up to delay_offmsg
+const uint8_t firstLayoutSize = 16;
+
+/// A field of the config
+struct Register {
+  uint8_t offset;
+  uint8_t size;
+  uint32_t min;
+  uint32_t max;
+};
+
+#define REGISTER(field, min, max) { offsetof(MyConfig_t, field), sizeof(((MyConfig_t *)0)->field), min, max }
+/// All the fields, in their order in MyConfig_t
+constexpr Register map[] PROGMEM = {
+  REGISTER(pos_stepdown,    0, 180),
+  REGISTER(pos_stepup,      0, 180),
+  REGISTER(steps_init,      1, stepsMax),
+  REGISTER(steps_min,       1, stepsMax),
+  REGISTER(steps_max,       1, stepsMax),
+  REGISTER(speed_init,      1, 255),
+  REGISTER(speed_min,       1, 255),
+  REGISTER(speed_max,       1, 255),
+  REGISTER(step_ratio,      1, 99),
+  REGISTER(delay_longpress, 1, 255),
+  REGISTER(delay_set,       1, 255),
+  REGISTER(delay_off,       1, 255),
+  REGISTER(delay_offmsg,    1, 255),
+  REGISTER(sync_mode,       0, 2),
+  REGISTER(servo_settle,    0, 255),
+  REGISTER(var_jitter,      0, 25),
+  REGISTER(var_drift,       0, cadence::driftMax),
+  REGISTER(var_fatigue,     0, cadence::fatigueMax),
+  REGISTER(gait_replay,     0, 1),
+  REGISTER(batt_low,        0, 255),
+  REGISTER(batt_off,        0, 255),
+  REGISTER(enc_accel,       0, 16),
+  REGISTER(disp_bright,     1, 16),
+  REGISTER(disp_dim,        0, 16)
+};
+#undef REGISTER
+/// Number of fields
+const uint8_t count = sizeof(map) / sizeof(map[0]);
+/// Do the fields from `index` follow each other from `offset` to the end of MyConfig_t? (compile time)
+constexpr bool contiguous(uint8_t index, uint8_t offset)
+{
+  return (index == count) ? (offset == sizeof(MyConfig_t))
+                          : ((map[index].offset == offset) && contiguous(index + 1, offset + map[index].size));
+}
+static_assert(contiguous(0, 0), "registers::map must hold every field of MyConfig_t, in order, without gap");
+
+/// Is the RAM copy newer than the EEPROM, and since when?
+bool dirty = false;
+tick_t changedAt;
+/// Are the changes applied at once? (not before the config is loaded)
+bool live = false;
+
+/// Editor: edited address, is the address (rather than the value) selected?
+uint8_t editAddress;
+bool addressSelected;
+
+/// Read a field from PROGMEM
+Register get(uint8_t index)
+{
+  Register r;
+  memcpy_P(&r, &map[index], sizeof(Register));
+  return r;
+}
+
+/// Index of the field holding `address` (count if none)
+uint8_t find(uint8_t address)
+{
+  for (uint8_t i = 0; i < count; i++)
+  {
+    Register r = get(i);
+    if ((address >= r.offset) && (address < r.offset + r.size))
+    {
+      return i;
+    }
+  }
+  return count;
+}
+
+/// Value of a field (little endian, as on the target)
+uint32_t value(const Register &r, const MyConfig_t &c)
+{
+  uint32_t v = 0;
+  for (uint8_t i = r.size; i > 0; i--)
+  {
+    v = (v << 8) | ((const uint8_t *)&c)[r.offset + i - 1];
+  }
+  return v;
+}
+
+/// Are all the fields of a config in their range, and consistent?
+bool isValid(const MyConfig_t &c)
+{
+  for (uint8_t i = 0; i < count; i++)
+  {
+    Register r = get(i);
+    uint32_t v = value(r, c);
+    if ((v < r.min) || (v > r.max))
+    {
+      return false;
+    }
+  }
+  return (c.steps_min <= c.steps_init) && (c.steps_init <= c.steps_max)
+      && (c.speed_min <= c.speed_init) && (c.speed_init <= c.speed_max)
+      && ((c.batt_off <= c.batt_low) || (c.batt_off == 0xff)); // 0xff: never (see battery::threshold())
+}
+
+/// Load the config at power up. The config of the first firmware is converted,
+/// a blank, unknown or invalid one is replaced by defaultConfig; both are written back.
+void loadConfig()
+{
+  uint8_t version = EEPROM.read(versionAddress);
+  if (version == configVersion)
+  {
+    EEPROM.get(0, config);
+    if (isValid(config))
+    {
+      return;
+    }
+  }
+  config = defaultConfig;
+  bool blank = true;
+  for (uint8_t a = 0; a < firstLayoutSize; a++)
+  {
+    blank &= (EEPROM.read(a) == 0xff);
+  }
+  if ((version == 0xff) && !blank)
+  { // First firmware: the step counts were 16-bit, the later fields did not exist
+    MyConfig_t first = defaultConfig;
+    uint16_t steps;
+    first.pos_stepdown = EEPROM.read(0);
+    first.pos_stepup = EEPROM.read(1);
+    EEPROM.get(2, steps);
+    first.steps_init = steps;
+    EEPROM.get(4, steps);
+    first.steps_min = steps;
+    EEPROM.get(6, steps);
+    first.steps_max = steps;
+    for (uint8_t a = 8; a < firstLayoutSize; a++)
+    { // speed_init to delay_offmsg
+      ((uint8_t *)&first)[offsetof(MyConfig_t, speed_init) + a - 8] = EEPROM.read(a);
+    }
+    if (isValid(first))
+    {
+      config = first;
+    }
+  }
+  EEPROM.put(0, config);
+  EEPROM.update(versionAddress, configVersion);
+}
+
+/// The RAM copy changed: apply it now, write it later
+void changed()
+{
+  dirty = true;
+  changedAt = ticks();
+  if (live)
+  {
+    applyConfig();
+    if (movements::speed < config.speed_min)
+    {
+      movements::speed = config.speed_min;
+    }
+    else if (movements::speed > config.speed_max)
+    {
+      movements::speed = config.speed_max;
+    }
+  }
+}
+
+/// Write the changes in EEPROM (only the bytes that changed)
+void flush()
+{
+  if (dirty)
+  {
+    EEPROM.put(0, config);
+    dirty = false;
+  }
+}
+
+/// Start applying the changes at once (the config is loaded). Called at the end of setup().
+void setupRegisters()
+{
+  live = true;
+}
+
+/// Write back the config once it is stable. Must be called from the main loop.
+void pollRegisters()
+{
+  if (dirty && (ticksSince(changedAt, ticks()) >= writeBackDelay))
+  {
+    flush();
+  }
+}
+
+/// Set the field starting at `address`. Out of range values are limited if `clamp`, refused otherwise.
+/// A value breaking the order of the steps, speeds or battery thresholds is always refused
+/// (such a config would be replaced by defaultConfig at the next power up).
+bool set(uint8_t address, uint32_t v, bool clamp)
+{
+  uint8_t i = find(address);
+  if (i == count)
+  {
+    return false;
+  }
+  Register r = get(i);
+  if ((v < r.min) || (v > r.max))
+  {
+    if (!clamp)
+    {
+      return false;
+    }
+    v = (v < r.min) ? r.min : r.max;
+  }
+  MyConfig_t candidate = config;
+  for (uint8_t k = 0; k < r.size; k++)
+  {
+    ((uint8_t *)&candidate)[r.offset + k] = (uint8_t)(v >> (8 * k));
+  }
+  if (!isValid(candidate))
+  {
+    return false;
+  }
+  config = candidate;
+  changed();
+  return true;
+}
+
+/// Value of the field starting at `address`
+uint32_t read(uint8_t address)
+{
+  uint8_t i = find(address);
+  return (i == count) ? 0 : value(get(i), config);
+}
+
+/// Read a byte of the config, or a memory probe
+uint8_t readByte(uint8_t address)
+{
+  if (memory::isProbe(address))
+  {
+    return memory::readProbe(address);
+  }
+  return (address < sizeof(MyConfig_t)) ? ((uint8_t *)&config)[address] : 0;
+}
+
+/// Write a byte of the config (probes are read-only): the field holding it must stay in its range
+bool writeByte(uint8_t address, uint8_t b, bool clamp)
+{
+  uint8_t i = find(address);
+  if (i == count)
+  {
+    return false;
+  }
+  Register r = get(i);
+  uint8_t shift = 8 * (address - r.offset);
+  uint32_t v = (value(r, config) & ~((uint32_t)0xff << shift)) | ((uint32_t)b << shift);
+  return set(r.offset, v, clamp);
+}
+
+/// Show the edited address and its value
+void displayEditor()
+{
+  userinterface::disp.write(editAddress, readByte(editAddress), true);
+  if (editAddress <= 1)
+  { // Servo positions: move to see them
+    movements::setMovements(readByte(editAddress));
+  }
+}
+
+/// Start the editor on the first address
+void startEditor()
+{
+  editAddress = 0;
+  addressSelected = true;
+  userinterface::displayClear();
+  displayEditor();
+  userinterface::disp.setCursor(3);
+  userinterface::disp.cursor();
+  movements::powerOnMovements();
+}
+
+/// Handle the button and the encoder in the editor. Returns false once left (long press).
+bool edit()
+{
+  if (BUTTON_RELEASED)
+  {
+    if (BUTTON_LONG_PRESSED)
+    {
+      userinterface::disp.noCursor();
+      movements::powerOffMovements();
+      flush();
+      return false;
+    }
+    addressSelected = !addressSelected;
+    userinterface::disp.setCursor(addressSelected ? 3 : 0);
+    USER_INTERACTION_DONE
+  }
+  if (userinterface::isEncoderRotated())
+  {
+    if (addressSelected)
+    {
+      if (userinterface::encoderChangeValue(&editAddress, memory::firstProbeAddress + memory::ProbeCount - 1))
+      {
+        buzzer::clicBuzzer();
+      }
+    }
+    else
+    {
+      uint8_t b = readByte(editAddress);
+      bool overflow = userinterface::encoderChangeValue(&b, 255);
+      // Out of range: limited to the range of the field
+      if (overflow || !writeByte(editAddress, b, true) || (readByte(editAddress) != b))
+      {
+        buzzer::clicBuzzer();
+      }
+    }
+    displayEditor();
+    USER_INTERACTION_DONE
+  }
+  return true;
+}
+} // namespace registers
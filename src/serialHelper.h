@@ -0,0 +1,473 @@
+#pragma once
+
+#include "globals.h"
+#include <util/crc16.h>
+
+/// Remote control through the serial port.
+///
+/// Commands are single lines (terminated by CR or LF) made of one letter
+/// optionally followed by its parameters:
+///  - `S <steps>`         Set the number of steps
+///  - `S <minutes>m`      Set a session by duration (see durationHelper.h)
+///  - `V <speed>`         Set the speed (steps by minute)
+///  - `G`                 Start (go) emulation
+///  - `P`                 Pause emulation
+///  - `X`                 Stop emulation (back to Init)
+///  - `?`                 Query status
+///  - `R <addr>`          Read a config byte (or a memory probe, see memoryHelper.h)
+///  - `W <addr> <value>`  Write a config byte (RAM and EEPROM)
+///  - `D`                 Dump the whole config image (hex)
+///  - `I <image>`         Restore a whole config image (hex)
+///  - `Y`                 Step beacon: a master unit just put its foot down
+///  - `L <n>`             Select program n (0: steps set by hand)
+///  - `M <offset> <hex>`  Write bytes in the program area (see programHelper.h)
+///  - `C <addr> [value]`  Read or write the whole config field at addr (see registersHelper.h)
+///  - `B`                 Battery: voltage (mV), level and runtime left (minutes, -1: unknown)
+///  - `E [0]`             Energy counters (see energyHelper.h), reset after if 0
+///  - `T`                 Oldest steps of the step log (see stepLogHelper.h)
+///  - `J`                 Oldest bytes of the input trace (see inputTraceHelper.h)
+/// A config image is the version byte, the bytes of MyConfig_t and a CRC-8
+/// (CCITT) computed over both, all in hexadecimal.
+/// Each command is answered by a line starting with `OK` or `ERR`.
+namespace serialcmd
+{
+/// Serial speed
+const unsigned long baudRate = 9600;
+/// Size of a config image (version + config + CRC)
+const uint8_t imageSize = sizeof(MyConfig_t) + 2;
+/// Maximum length of a command line (without terminator)
+const uint8_t lineMax = 2 + 2 * imageSize;
+
+/// Characters received for the current line
+char line[lineMax + 1];
+/// Number of characters in line
+uint8_t lineLen;
+/// Line too long, will be rejected at its end
+bool lineOverflow;
+
+/// Initialize the serial command interface
+void setupSerialCommands()
+{
+    Serial.begin(baudRate);
+    lineLen = 0;
+    lineOverflow = false;
+}
+
+/// Parse a decimal number, skipping leading spaces. Returns false if none.
+bool parseNumber(const char **p, unsigned long *value)
+{
+    const char *c = *p;
+    while (*c == ' ')
+    {
+        c++;
+    }
+    if ((*c < '0') || (*c > '9'))
+    {
+        return false;
+    }
+    unsigned long v = 0;
+    while ((*c >= '0') && (*c <= '9'))
+    {
+        v = v * 10 + (unsigned long)(*c - '0');
+        c++;
+    }
+    *p = c;
+    *value = v;
+    return true;
+}
+
+/// Value of an hexadecimal digit, or 0xff if not an hexadecimal digit
+uint8_t hexValue(char c)
+{
+    if ((c >= '0') && (c <= '9'))
+    {
+        return c - '0';
+    }
+    c |= 0x20; // lower case
+    if ((c >= 'a') && (c <= 'f'))
+    {
+        return c - 'a' + 10;
+    }
+    return 0xff;
+}
+
+/// Send a byte in hexadecimal
+void sendHex(uint8_t value)
+{
+    const char hex[] = "0123456789abcdef";
+    Serial.print(hex[value >> 4]);
+    Serial.print(hex[value & 0x0f]);
+}
+
+/// Send the whole config image
+void sendConfigImage()
+{
+    uint8_t crc = _crc8_ccitt_update(0, registers::configVersion);
+    Serial.print("OK ");
+    sendHex(registers::configVersion);
+    for (uint8_t i = 0; i < sizeof(MyConfig_t); i++)
+    {
+        uint8_t b = ((uint8_t *)&config)[i];
+        crc = _crc8_ccitt_update(crc, b);
+        sendHex(b);
+    }
+    sendHex(crc);
+    Serial.println();
+}
+
+/// Decode, check and apply a config image. Nothing is changed on error.
+bool receiveConfigImage(const char *p)
+{
+    uint8_t image[imageSize];
+    uint8_t crc = 0;
+    while (*p == ' ')
+    {
+        p++;
+    }
+    for (uint8_t i = 0; i < imageSize; i++)
+    {
+        uint8_t hi = hexValue(*p++);
+        if (hi > 0x0f)
+        {
+            return false;
+        }
+        uint8_t lo = hexValue(*p++);
+        if (lo > 0x0f)
+        {
+            return false;
+        }
+        image[i] = (hi << 4) | lo;
+        crc = _crc8_ccitt_update(crc, image[i]);
+    }
+    // CRC over data followed by its own CRC is always 0
+    if ((*p != '\0') || (image[0] != registers::configVersion) || (crc != 0))
+    {
+        return false;
+    }
+    MyConfig_t newConfig;
+    memcpy(&newConfig, image + 1, sizeof(MyConfig_t));
+    if (!registers::isValid(newConfig))
+    {
+        return false;
+    }
+    config = newConfig;
+    registers::changed();
+    registers::flush();
+    return true;
+}
+
+/// Decode hexadecimal bytes and write them in the program area. Nothing is written on error.
+bool writeProgramBytes(unsigned long offset, const char *p)
+{
+    uint8_t bytes[lineMax / 2];
+    uint8_t count = 0;
+    while (*p == ' ')
+    {
+        p++;
+    }
+    while (*p != '\0')
+    {
+        uint8_t hi = hexValue(*p++);
+        uint8_t lo = hexValue(*p++);
+        if ((hi > 0x0f) || (lo > 0x0f))
+        {
+            return false;
+        }
+        bytes[count++] = (hi << 4) | lo;
+    }
+    if ((count == 0) || (offset + count > program::programSize))
+    {
+        return false;
+    }
+    for (uint8_t i = 0; i < count; i++)
+    {
+        EEPROM.update(program::programBase + offset + i, bytes[i]);
+    }
+    return true;
+}
+
+/// Send the status line
+void sendStatus()
+{
+    Serial.print("OK ");
+    Serial.print((int)stateMachine::state);
+    Serial.print(' ');
+    Serial.print(movements::stepsRemaining);
+    Serial.print(' ');
+    Serial.println((unsigned int)movements::speed);
+}
+
+/// Is the step engine running (or about to run)?
+bool isEmulating()
+{
+    return (stateMachine::state == stateMachine::States::Emulate)
+        || (stateMachine::state == stateMachine::States::ChangeSpeed);
+}
+
+/// Execute a complete command line. Returns false on error.
+bool execute()
+{
+    const char *p = line + 1;
+    unsigned long a = 0;
+    unsigned long b = 0;
+    switch (line[0])
+    {
+        case 'S':
+        case 's':
+            if (!parseNumber(&p, &a) || isEmulating())
+            {
+                return false;
+            }
+            if ((*p == 'm') || (*p == 'M'))
+            { // Duration (minutes), the steps are counted at the start
+                if ((a < 1) || (a > duration::minutesMax) || (stateMachine::state == stateMachine::States::Paused))
+                {
+                    return false;
+                }
+                duration::setMinutes(a);
+            }
+            else
+            {
+                if ((a < config.steps_min) || (a > config.steps_max))
+                {
+                    return false;
+                }
+                duration::setMinutes(0);
+                movements::stepsRemaining = a;
+                if (stateMachine::state != stateMachine::States::Paused)
+                {
+                    registers::set(offsetof(MyConfig_t, steps_init), movements::stepsRemaining, true);
+                }
+            }
+            program::selected = 0;
+            userinterface::disp.noCursor();
+            userinterface::displaySteps();
+            if (stateMachine::state == stateMachine::States::AdjustSteps)
+            {
+                stateMachine::changeState(stateMachine::States::SetSteps);
+            }
+            break;
+        case 'V':
+        case 'v':
+            if (!parseNumber(&p, &a) || (a < config.speed_min) || (a > config.speed_max))
+            {
+                return false;
+            }
+            movements::speed = (unsigned char)a;
+            if (stateMachine::state == stateMachine::States::ChangeSpeed)
+            {
+                userinterface::displaySpeed();
+            }
+            break;
+        case 'G':
+        case 'g':
+            switch (stateMachine::state)
+            {
+                case stateMachine::States::SetSteps:
+                case stateMachine::States::AdjustSteps:
+                    userinterface::disp.noCursor();
+                    stateMachine::changeState(stateMachine::States::Emulate);
+                    break;
+                case stateMachine::States::Paused:
+                    UNBLANK_SCREEN
+                    stateMachine::changeState(stateMachine::States::Emulate);
+                    break;
+                default:
+                    if (!isEmulating())
+                    {
+                        return false;
+                    }
+                    break;
+            }
+            break;
+        case 'P':
+        case 'p':
+            if (isEmulating())
+            {
+                userinterface::disp.noCursor();
+                userinterface::displaySteps();
+                stateMachine::changeState(stateMachine::States::Paused);
+            }
+            else if (stateMachine::state != stateMachine::States::Paused)
+            {
+                return false;
+            }
+            break;
+        case 'X':
+        case 'x':
+            if (stateMachine::state == stateMachine::States::PowerOff)
+            {
+                return false;
+            }
+            UNBLANK_SCREEN
+            stateMachine::changeState(stateMachine::States::Init);
+            break;
+        case '?':
+            sendStatus();
+            return true;
+        case 'R':
+        case 'r':
+            if (!parseNumber(&p, &a) || (a >= memory::firstProbeAddress + memory::ProbeCount))
+            {
+                return false;
+            }
+            Serial.print("OK ");
+            Serial.println((unsigned int)registers::readByte(a));
+            return true;
+        case 'W':
+        case 'w':
+            // Applied now, written in EEPROM a bit later
+            if (!parseNumber(&p, &a) || !parseNumber(&p, &b)
+                || (a >= sizeof(MyConfig_t)) || (b > 255) || !registers::writeByte(a, b, false))
+            {
+                return false;
+            }
+            break;
+        case 'C':
+        case 'c':
+            if (!parseNumber(&p, &a) || (a >= sizeof(MyConfig_t)) || (registers::find(a) == registers::count))
+            {
+                return false;
+            }
+            if (parseNumber(&p, &b))
+            {
+                if (!registers::set(a, b, false))
+                {
+                    return false;
+                }
+                break;
+            }
+            Serial.print("OK ");
+            Serial.println(registers::read(a));
+            return true;
+        case 'D':
+        case 'd':
+            sendConfigImage();
+            return true;
+        case 'I':
+        case 'i':
+            if (isEmulating() || !receiveConfigImage(p))
+            {
+                return false;
+            }
+            break;
+        case 'L':
+        case 'l':
+            if (!parseNumber(&p, &a) || isEmulating() || (a > program::programMax))
+            {
+                return false;
+            }
+            program::select((int8_t)a - program::selected);
+            if (program::selected != a)
+            {
+                return false;
+            }
+            if (program::selected > 0)
+            {
+                duration::setMinutes(0);
+            }
+            if (stateMachine::state == stateMachine::States::SetSteps)
+            {
+                stateMachine::changeState(stateMachine::States::SetSteps);
+            }
+            break;
+        case 'M':
+        case 'm':
+            // Not under a program running from these bytes (paused included)
+            if (isEmulating() || program::running || !parseNumber(&p, &a) || !writeProgramBytes(a, p))
+            {
+                return false;
+            }
+            break;
+        case 'B':
+        case 'b':
+            Serial.print("OK ");
+            Serial.print(battery::voltage);
+            Serial.print(' ');
+            Serial.print((unsigned int)battery::level);
+            Serial.print(' ');
+            Serial.println((battery::minutesLeft() == 0xffffffffUL) ? -1L : (long)battery::minutesLeft());
+            return true;
+        case 'E':
+        case 'e':
+            if (parseNumber(&p, &a))
+            { // Read and reset
+                if (a != 0)
+                {
+                    return false;
+                }
+                energy::sendEnergy();
+                energy::resetEnergy();
+                return true;
+            }
+            energy::sendEnergy();
+            return true;
+        case 'T':
+        case 't':
+            if (!features::stepLog)
+            {
+                return false;
+            }
+            steplog::sendStepLog();
+            return true;
+        case 'J':
+        case 'j':
+            if (!features::inputTrace)
+            {
+                return false;
+            }
+            inputtrace::sendTrace();
+            return true;
+        case 'Y':
+        case 'y':
+            // Sent by the master at each step: no answer to keep the bus free
+            sync::onBeacon();
+            return true;
+        default:
+            return false;
+    }
+    Serial.println("OK");
+    return true;
+}
+
+/// Is the line an answer (`OK` or `ERR`)? The master answers the commands of
+/// its computer on the bus, the followers must not take them for commands.
+bool isAnswer()
+{
+    return (strncmp(line, "OK", 2) == 0) || (strncmp(line, "ERR", 3) == 0);
+}
+
+/// Consume the received characters without blocking. Must be called from the main loop.
+void pollSerialCommands()
+{
+    while (Serial.available() > 0)
+    {
+        char c = (char)Serial.read();
+        if ((c == '\r') || (c == '\n'))
+        {
+            if (lineOverflow)
+            {
+                Serial.println("ERR");
+            }
+            else if (lineLen > 0)
+            {
+                line[lineLen] = '\0';
+                if (!(sync::isFollower() && isAnswer()) && !execute())
+                {
+                    Serial.println("ERR");
+                }
+            }
+            lineLen = 0;
+            lineOverflow = false;
+        }
+        else if (lineLen < lineMax)
+        {
+            line[lineLen++] = c;
+        }
+        else
+        {
+            lineOverflow = true;
+        }
+    }
+}
+} // namespace serialcmd
@@ -5,28 +5,44 @@
 /// Methods for the main state macheine
 namespace stateMachine {
 
-/// List of states
-enum States : int8_t {
-  PowerOff = -1,
-  Init = 0,
-  SetSteps,
-  AdjustSteps,
-  Emulate,
-  Paused,
-  ChangeSpeed,
-  Finished
-} state;
+/// Actual state
+States state;
+
+/// Edge of the button (INT0): when pressed, freeze the steps without waiting for the main loop
+void onButtonChanged()
+{
+  bool pressed = !digitalRead(board::pinEncS);
+  inputtrace::onButton(pressed);
+  if (pressed && ((state == States::Emulate) || (state == States::ChangeSpeed)))
+  {
+    movements::freeze();
+  }
+}
+
+/// Watch the button by interrupt (INT0 is also used to wake up)
+void attachButtonInterrupt()
+{
+  attachInterrupt(digitalPinToInterrupt(board::pinEncS), onButtonChanged, CHANGE);
+}
 
 /// Initialize the state machine
 void setupStateMachine() {
     state = States::Init;
+    attachButtonInterrupt();
 }
 
 /// Must be called to change the state
 void changeState(States newstate) {
   switch (newstate) {
     case SetSteps:
-      userinterface::displaySteps();
+      if (program::selected > 0)
+      {
+        program::displayProgram();
+      }
+      else
+      {
+        userinterface::displaySteps();
+      }
       userinterface::disp.setCursor(3);
       break;
     case AdjustSteps:
@@ -34,7 +50,15 @@ void changeState(States newstate) {
       userinterface::disp.cursor();
       break;
     case Emulate:
-      // disp.setCursor(2);
+      if ((state == SetSteps) || (state == AdjustSteps))
+      {
+        program::start();
+        duration::start();
+        userinterface::displaySteps();
+      }
+      break;
+    case EditConfig:
+      registers::startEditor();
       break;
     case PowerOff:
       buzzer::muteBuzzer();
@@ -46,6 +70,11 @@ void changeState(States newstate) {
     default:
       break;
   }
+  if ((newstate != Emulate) && (newstate != ChangeSpeed))
+  { // Paused or stopped: the freeze is over
+    movements::frozen = false;
+  }
+  inputtrace::onState(newstate);
   USER_INTERACTION_DONE
   state = newstate;
 }
@@ -64,8 +93,16 @@ void doState()
       {
         userinterface::resetEncoderButton();
       }
+      program::stop();
+      // Stopped (long press, X, end): the next walk starts its own cadence and gait
+      movements::stopMovements();
       movements::stepsRemaining = config.steps_init;
       movements::speed = config.speed_init;
+      duration::enable(duration::enabled);
+      if (battery::restoreCheckpoint())
+      { // Resumed by steps
+        duration::setMinutes(0);
+      }
       userinterface::displayClear();
       userinterface::disp.setCursor(3);
       userinterface::displaySteps();
@@ -75,15 +112,55 @@ void doState()
     case States::SetSteps:
       if (BUTTON_RELEASED)
       {
-        if (BUTTON_LONG_PRESSED)
+        if (BUTTON_CONFIG_PRESSED)
+        {
+          changeState(States::EditConfig);
+        }
+        else if (BUTTON_LONG_PRESSED)
         {
           changeState(States::Emulate);
         }
         else
         {
+          if (program::selected > 0)
+          { // Back to steps set by hand
+            program::selected = 0;
+            userinterface::displaySteps();
+          }
           changeState(States::AdjustSteps);
         }
       }
+      else if (userinterface::isEncoderRotated())
+      {
+        if (duration::enabled)
+        { // Clockwise: back to the steps
+          if (userinterface::rot > 0)
+          {
+            duration::setMinutes(0);
+          }
+        }
+        else if ((userinterface::rot < 0) && (program::selected == 0))
+        { // Counterclockwise from the steps: session by duration
+          duration::enable(true);
+        }
+        else
+        {
+          program::select(userinterface::rot);
+        }
+        if (program::selected > 0)
+        {
+          program::displayProgram();
+        }
+        else
+        {
+          userinterface::displaySteps();
+        }
+        USER_INTERACTION_DONE
+      }
+      else if (BUTTON_PRESSED && BUTTON_CONFIG_PRESSED)
+      { // Released now, the config is edited: [===]
+        userinterface::displayBars();
+      }
       else if (LAST_USER_INTERACTION_DELAY > powerOffDelay)
       {
         changeState(States::PowerOff);
@@ -94,8 +171,10 @@ void doState()
       {
         if (BUTTON_LONG_PRESSED)
         {
-          config.steps_init = movements::stepsRemaining;
-          // TODO: save to EEPROM
+          if (!duration::enabled)
+          {
+            registers::set(offsetof(MyConfig_t, steps_init), movements::stepsRemaining, true);
+          }
           changeState(States::Emulate);
         }
         else
@@ -104,12 +183,23 @@ void doState()
         }
         USER_INTERACTION_DONE 
       }
+      else if (userinterface::isEncoderRotated() && duration::enabled)
+      {
+        if (!duration::adjust(userinterface::acceleratedRot(), userinterface::disp.getCursor()))
+        {
+          buzzer::clicBuzzer();
+        }
+        userinterface::displaySteps();
+        USER_INTERACTION_DONE
+      }
       else if (userinterface::isEncoderRotated())
       {
-        int8_t r = userinterface::rot;
-        unsigned int stepdiff = (unsigned int)abs(r);
-        unsigned int rank = 1;
-        unsigned char p = userinterface::disp.getCursor();
+        int r = userinterface::acceleratedRot();
+        unsigned long stepdiff = (unsigned long)abs(r);
+        unsigned long rank = 1;
+        // Rank of the digit under the cursor (the display may be in thousands)
+        unsigned char scale = userinterface::disp.getScale();
+        unsigned char p = userinterface::disp.getCursor() + scale;
         while (p > 0)
         {
           rank *= 10;
@@ -146,6 +236,10 @@ void doState()
           }
         }
         userinterface::displaySteps();
+        // The display changed of scale: the cursor follows its rank, so the next
+        // detents of a flick do not change a rank 10 times higher
+        int cursor = (int)userinterface::disp.getCursor() + scale - userinterface::disp.getScale();
+        userinterface::disp.setCursor((cursor < 0) ? 0 : (cursor > CURSOR_MAX) ? CURSOR_MAX : cursor);
         USER_INTERACTION_DONE
       }
       else if (LAST_USER_INTERACTION_DELAY > setTimeout)
@@ -208,10 +302,11 @@ void doState()
         }
         else if (userinterface::isEncoderRotated())
         {
-          unsigned int r = (unsigned int)abs(userinterface::rot);
-          if (userinterface::rot > 0)
+          int rot = userinterface::acceleratedRot();
+          unsigned int r = (unsigned int)abs(rot);
+          if (rot > 0)
           {
-            if ((movements::speed + r) > config.speed_max)
+            if (r > (unsigned int)(config.speed_max - movements::speed))
             {
               r = config.speed_max - movements::speed;
               buzzer::clicBuzzer();
@@ -220,7 +315,7 @@ void doState()
           }
           else
           {
-            if ((movements::speed - r) < config.speed_min)
+            if (r > (unsigned int)(movements::speed - config.speed_min))
             {
               r = movements::speed - config.speed_min;
               buzzer::clicBuzzer();
@@ -286,6 +381,17 @@ void doState()
         }
       }
       break;
+    case States::EditConfig:
+      if (!registers::edit())
+      {
+        changeState(States::Init);
+      }
+      else if (LAST_USER_INTERACTION_DELAY > powerOffDelay)
+      {
+        movements::powerOffMovements();
+        changeState(States::PowerOff);
+      }
+      break;
     case States::PowerOff:
       if (BUTTON_PRESSED)
       {
@@ -298,7 +404,9 @@ void doState()
         BLANK_SCREEN
         if (!userinterface::disp.isDisplay())
         {
+            registers::flush();
             power::goToSleepAndWaitWakeUp();
+            attachButtonInterrupt();
             changeState(States::Init);
         }
       }
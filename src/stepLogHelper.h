@@ -0,0 +1,128 @@
+#pragma once
+
+#include "globals.h"
+
+/// Reference of the steps for external verification.
+///
+/// At each foot down, board::pinStepSync gives a pulse of pulseMs (its rising
+/// edge is the foot down) and the time of the step is logged in a RAM ring.
+/// The ring holds the time between two steps (ms, 16 bits): it is drained by
+/// the serial command `T`, which sends the number and the time (millis()) of
+/// the oldest step, then the time from each step to the next one. An answer
+/// holds up to drainMax steps, to fit in the serial buffer without waiting.
+/// When the ring is full the oldest steps are dropped, and the log restarts
+/// if a step comes too long after the previous one (more than 65 s): the
+/// number of the oldest step shows the steps lost between two `T`.
+namespace steplog
+{
+/// Length of the pulse (ms)
+const unsigned long pulseMs = 5;
+/// Steps kept in the ring
+const uint8_t ringSize = 32;
+/// Most steps sent by answer
+const uint8_t drainMax = 7;
+/// Room in the serial transmit buffer (64 bytes, one always empty)
+const uint8_t txRoom = 63;
+/// Longest answer: "OK ", number and time of the oldest step (32 bits), then ' ' and
+/// a 16-bit time for each other step, and "\r\n"
+const uint8_t answerMax = 3 + 10 + 1 + 10 + 6 * (drainMax - 1) + 2;
+static_assert(answerMax <= txRoom, "An answer of T must fit in the serial buffer");
+
+/// Time from each step to the previous one (ms), oldest at `tail`
+uint16_t ring[ringSize];
+uint8_t head = 0;
+uint8_t tail = 0;
+uint8_t used = 0;
+/// Number and time of the oldest step in the ring, time of the last one
+uint32_t oldestIndex = 0;
+tick_t oldestAt;
+tick_t lastAt;
+/// Number of steps since power up
+uint32_t count = 0;
+/// Is the pulse in progress?
+bool pulsing = false;
+
+/// Setup the sync output
+void setupStepLog()
+{
+  if (!features::stepLog)
+  {
+    return;
+  }
+  pinMode(board::pinStepSync, OUTPUT);
+  digitalWrite(board::pinStepSync, LOW);
+}
+
+/// Called by movements at each foot down (first, for a precise pulse)
+void onFootDown()
+{
+  if (!features::stepLog)
+  {
+    return;
+  }
+  digitalWrite(board::pinStepSync, HIGH);
+  pulsing = true;
+  tick_t now = ticks();
+  tick_t delta = ticksSince(lastAt, now);
+  lastAt = now;
+  count++;
+  if ((used > 0) && (delta > 0xffffUL))
+  { // Not drained for too long: restart from this step
+    used = 0;
+    tail = head;
+  }
+  if (used == 0)
+  {
+    oldestIndex = count;
+    oldestAt = now;
+  }
+  else if (used == ringSize)
+  { // Drop the oldest step
+    tail = (tail + 1) % ringSize;
+    used--;
+    oldestIndex++;
+    oldestAt += ring[tail];
+  }
+  ring[head] = (uint16_t)delta;
+  head = (head + 1) % ringSize;
+  used++;
+}
+
+/// End the pulse. Must be called from the main loop.
+void pollStepLog()
+{
+  if (pulsing && (ticksSince(lastAt, ticks()) >= pulseMs))
+  {
+    digitalWrite(board::pinStepSync, LOW);
+    pulsing = false;
+  }
+}
+
+/// Send and drop the oldest steps of the log: number and time of the first one, then the time to each next one
+void sendStepLog()
+{
+  if (used == 0)
+  {
+    Serial.println("OK");
+    return;
+  }
+  uint8_t n = (used > drainMax) ? drainMax : used;
+  Serial.print("OK ");
+  Serial.print(oldestIndex);
+  Serial.print(' ');
+  Serial.print(oldestAt);
+  for (uint8_t i = 1; i < n; i++)
+  {
+    tail = (tail + 1) % ringSize;
+    oldestAt += ring[tail];
+    Serial.print(' ');
+    Serial.print(ring[tail]);
+  }
+  Serial.println();
+  // The next step becomes the oldest one
+  tail = (tail + 1) % ringSize;
+  used -= n;
+  oldestIndex += n;
+  oldestAt += ring[tail];
+}
+} // namespace steplog
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "globals.h"
+
+/// Synchronization of several units on a serial bus.
+///
+/// The TX of the master is wired to the RX of all the followers. The master
+/// sends the serial commands matching its own actions (`S`, `V`, `G`, `P`,
+/// `X`) and a beacon `Y` at each foot down. Followers execute the commands as
+/// if they came from a computer and align the phase of their steps on the
+/// beacons (see movements::syncFootDown()). The answers of the master to its
+/// computer (`OK`, `ERR`) also go on the bus: followers ignore them.
+namespace sync
+{
+/// Synchronization modes (config.sync_mode)
+enum Modes : uint8_t {
+  Standalone = 0,
+  Master,
+  Follower
+};
+
+/// Delay between a foot down of the master and the handling of its beacon (ms)
+/// "Y\r" at 9600 bauds + main loop
+const unsigned long beaconLatency = 3;
+
+/// Last state sent by the master
+stateMachine::States sentState = stateMachine::States::Init;
+/// Last speed sent by the master
+unsigned char sentSpeed = 0;
+
+/// Is this unit the master of the bus?
+bool isMaster()
+{
+  return features::sync && (config.sync_mode == Modes::Master);
+}
+
+/// Is this unit following a master?
+bool isFollower()
+{
+  return features::sync && (config.sync_mode == Modes::Follower);
+}
+
+/// Send the changes of the master to the followers. Must be called from the main loop.
+void pollSync()
+{
+  if (!isMaster())
+  {
+    return;
+  }
+  if (movements::speed != sentSpeed)
+  {
+    sentSpeed = movements::speed;
+    Serial.print("V ");
+    Serial.println((unsigned int)sentSpeed);
+  }
+  // Emulate and ChangeSpeed are the same for the followers
+  stateMachine::States state = stateMachine::state;
+  if (state == stateMachine::States::ChangeSpeed)
+  {
+    state = stateMachine::States::Emulate;
+  }
+  if (state != sentState)
+  {
+    switch (state)
+    {
+      case stateMachine::States::Emulate:
+        Serial.print("S ");
+        Serial.println(movements::stepsRemaining);
+        Serial.println("G");
+        break;
+      case stateMachine::States::Paused:
+        Serial.println("P");
+        break;
+      case stateMachine::States::Init:
+        Serial.println("X");
+        break;
+      default:
+        break;
+    }
+    sentState = state;
+  }
+}
+
+/// Called by movements at each foot down
+void onFootDown()
+{
+  if (isMaster())
+  {
+    Serial.println("Y");
+  }
+}
+
+/// Called when a beacon of the master is received
+void onBeacon()
+{
+  if (isFollower())
+  {
+    movements::syncFootDown(beaconLatency);
+  }
+}
+} // namespace sync
@@ -2,22 +2,14 @@
 
 #include "globals.h"
 #include "buzzerHelper.h"
+#include "inputTraceHelper.h"
+#include "durationHelper.h"
 #include <Button.h>
 #include <Display.h>
 
 /// Methods to manage UI (screen and buttons)
 namespace userinterface
 {
-#define PIN_ENCS          2 // INT0
-#define PIN_ENCA          3 // INT1
-#define PIN_ENCB          4
-
-#define PIN_SR_DI         5
-#define PIN_SR_CK         6
-#define PIN_SR_ST         7
-#define PIN_CD4017_MR     8
-#define PIN_DIGIT_ENA     9
-
 #define DOT_STEP                0
 #define DOT_SPEED               1
 #define DOT_TIME                2
@@ -26,13 +18,25 @@ namespace userinterface
 
 /// Debounce time (in ms)
 const unsigned long debounceTime = 5;
+/// Encoder acceleration: time between detents from which the turn is accelerated, and
+/// after which a turn is a new one (ms)
+const uint8_t slowDetentTime = 100;
+const uint8_t idleDetentTime = 250;
+/// Most detents counted for one
+const uint8_t accelerationMax = 50;
+/// Time without user interaction before dimming the display (ms)
+const unsigned long dimDelay = 30000;
 
-Display disp(PIN_SR_CK, PIN_SR_DI, PIN_SR_ST, PIN_CD4017_MR, PIN_DIGIT_ENA);
-Button encbtn(PIN_ENCS);
+Display<board::DisplayPins> disp;
+Button encbtn(board::pinEncS);
 
 volatile int8_t rot;
+/// Time between detents (ms), filtered: a fast turn has a short one
+volatile uint8_t detentTime = idleDetentTime;
+void onEncoderTurned();
+
 /// Last time digits was changed
-unsigned long lastUserInteractionAt;
+tick_t lastUserInteractionAt;
 /// Long press delay
 unsigned long longPressDelay;
 
@@ -40,15 +44,15 @@ unsigned long longPressDelay;
 void setupUI()
 {
     // Set up encoder --------------------------------------------------------
-    pinMode(PIN_ENCA, INPUT);
-    pinMode(PIN_ENCB, INPUT);
+    pinMode(board::pinEncA, INPUT);
+    pinMode(board::pinEncB, INPUT);
 
     lastUserInteractionAt = 0UL;
     longPressDelay = 1000;  // 1 second
 
     rot = 0;
     // On Uno card, only pins 2 and 3 are hardware interrupts
-    attachInterrupt(digitalPinToInterrupt(PIN_ENCA), onEncoderTurned, FALLING);
+    attachInterrupt(digitalPinToInterrupt(board::pinEncA), onEncoderTurned, FALLING);
 
     // Set up display --------------------------------------------------------
     disp.begin();
@@ -56,9 +60,23 @@ void setupUI()
     disp.lampTest();
 }
 
+/// Dim the display after some time without user interaction (config.disp_bright, config.disp_dim),
+/// full brightness is back on any input
+void updateBrightness()
+{
+  if (config.disp_bright == 0)
+  { // Config not loaded yet
+    return;
+  }
+  bool idle = (config.disp_dim > 0) && (LAST_USER_INTERACTION_DELAY > dimDelay)
+           && (rot == 0) && !encbtn.isPressed();
+  disp.setBrightness((idle && (config.disp_dim < config.disp_bright)) ? config.disp_dim : config.disp_bright);
+}
+
 /// Refresh display and check buttons
 void refreshUI()
 {
+  updateBrightness();
   disp.writeDot(DOT_LONGPRESS, encbtn.isPressed() && (encbtn.getPressedDuration() > longPressDelay));
   disp.displayNextDigit();
   encbtn.check();
@@ -94,12 +112,20 @@ void displayOff()
   disp.write(0, 0x8e); // F
 }
 
-/// Display number of steps
+/// Display number of steps, or the time left (MMMSS) in a session by duration
 void displaySteps()
 {
-  disp.write(movements::stepsRemaining);
+  if (duration::enabled)
+  {
+    disp.write(duration::leftMinutes * 100UL + duration::leftSeconds);
+  }
+  else
+  {
+    disp.write(movements::stepsRemaining);
+  }
   disp.writeDot(DOT_SPEED, false);
-  disp.writeDot(DOT_STEP, true);
+  disp.writeDot(DOT_STEP, !duration::enabled);
+  disp.writeDot(DOT_TIME, duration::enabled);
 }
 
 /// Display speed
@@ -107,6 +133,7 @@ void displaySpeed()
 {
   disp.write(movements::speed);
   disp.writeDot(DOT_STEP, false);
+  disp.writeDot(DOT_TIME, false);
   disp.writeDot(DOT_SPEED, true);
 }
 
@@ -135,6 +162,20 @@ bool isEncoderRotated()
   return rot != 0;
 }
 
+/// Rotation with the acceleration curve applied (config.enc_accel): single detents
+/// below 1000 / slowDetentTime detents by second, then growing with the square of the rate
+int acceleratedRot()
+{
+  uint8_t time = detentTime;
+  if ((config.enc_accel == 0) || (time >= slowDetentTime))
+  {
+    return rot;
+  }
+  unsigned int excess = 1000U / time - 1000U / slowDetentTime;
+  unsigned long gain = 1UL + ((unsigned long)config.enc_accel * excess * excess) / 256UL;
+  return rot * (int)((gain > accelerationMax) ? accelerationMax : gain);
+}
+
 /// Handle encoder rotation
 bool encoderChangeValue(uint8_t *value, const uint8_t maxValue)
 {
@@ -162,10 +203,32 @@ bool encoderChangeValue(uint8_t *value, const uint8_t maxValue)
  */
 /// Interrupt raised each time the encoder is turned
 void onEncoderTurned() {
-  volatile static unsigned long rotatedAt = 0;
-  if ((millis() - rotatedAt) > debounceTime)
+  volatile static tick_t rotatedAt = 0;
+  volatile static bool clockwise = false;
+  volatile static bool turning = false;
+  tick_t elapsed = ticksSince(rotatedAt, ticks());
+  // Read once: the trace records the direction that is applied, even if B bounces
+  bool cw = !digitalRead(board::pinEncB);
+  inputtrace::onEncoder(cw);
+  if (elapsed > debounceTime)
   { // Debounce
-    if (digitalRead(PIN_ENCB))
+    // Rate of the turn: exponential filter of the time between detents
+    if ((elapsed >= idleDetentTime) || (cw != clockwise))
+    { // New turn: slow until a second detent
+      detentTime = idleDetentTime;
+      turning = false;
+    }
+    else if (!turning)
+    {
+      detentTime = elapsed;
+      turning = true;
+    }
+    else
+    {
+      detentTime = (3U * detentTime + elapsed + 2U) >> 2;
+    }
+    clockwise = cw;
+    if (!cw)
     {
       if (rot == -128)
       { // Overflow
@@ -195,7 +258,7 @@ void onEncoderTurned() {
         rot++;
       }
     }
-    rotatedAt = millis();
+    rotatedAt = ticks();
   }
 }
 
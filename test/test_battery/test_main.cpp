@@ -0,0 +1,109 @@
+// Battery monitor: the batteries run down during a session (warning at 5.0 V, saved at 4.6 V),
+// then new batteries are put in and the session is resumed where it stopped
+#include <stdio.h>
+#include <unity.h>
+#include "harness.h"
+
+using namespace harness;
+
+/// Session and batteries: 6 V, 300 uV by servo move, 20 uV by second attached
+const unsigned long steps = 5000;
+const unsigned long speed = 100;
+const unsigned long batteryMv = 6000;
+const unsigned long uvByMove = 300;
+const unsigned long uvBySecond = 20;
+
+/// Steps remaining when the session was saved
+unsigned long saved;
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+/// The session is saved and the unit sleeps before the batteries are empty
+void test_saved_before_brownout()
+{
+    char cmd[32];
+    int state = 0;
+    snprintf(cmd, sizeof(cmd), "W %d 50", batteryAddress);
+    command(cmd);
+    snprintf(cmd, sizeof(cmd), "W %d 46", batteryAddress + 1);
+    command(cmd);
+    snprintf(cmd, sizeof(cmd), "S %lu", steps);
+    command(cmd);
+    snprintf(cmd, sizeof(cmd), "V %lu", speed);
+    command(cmd);
+    command("G");
+    unsigned long remaining = steps;
+    long minutes = -1;
+    do
+    {
+        run(1000);
+        remaining = remainingSteps(&state);
+        if ((sim::now() / 1000000) % 60 == 0)
+        {
+            unsigned int voltage = 0;
+            unsigned int level = 0;
+            sscanf(command("B").c_str(), "OK %u %u %ld", &voltage, &level, &minutes);
+        }
+    } while ((remaining > 0) && (state != -1));
+    TEST_ASSERT_EQUAL_INT_MESSAGE(-1, state, "powered off before the end of the session");
+    TEST_ASSERT_TRUE_MESSAGE(minutes >= 0, "runtime estimated");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(steps - remaining, sim::footDowns().size(), "steps done");
+    saved = remaining;
+}
+
+/// New batteries: the session is restored at wake up, as many times as needed
+void test_resumed_with_new_batteries()
+{
+    int state = -1;
+    unsigned long remaining = saved;
+    while (state == -1)
+    {
+        sim::setBattery(batteryMv, uvByMove, uvBySecond);
+        run(10000);
+        unsigned long restored = remainingSteps(&state);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(remaining, restored, "restored steps remaining");
+        command("G");
+        do
+        {
+            run(1000);
+            remaining = remainingSteps(&state);
+        } while ((remaining > 0) && (state != -1));
+    }
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(steps, sim::footDowns().size(), "steps");
+}
+
+/// Thresholds left erased (0xff): no monitor, the session goes to its end on low batteries
+void test_erased_thresholds()
+{
+    char cmd[32];
+    int state;
+    resume();
+    snprintf(cmd, sizeof(cmd), "W %d 255", batteryAddress);
+    command(cmd);
+    snprintf(cmd, sizeof(cmd), "W %d 255", batteryAddress + 1);
+    command(cmd);
+    sim::setBattery(4000, 0, 0);
+    session(100, 100, &state);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(6, state, "finished");
+    unsigned int voltage = 0;
+    unsigned int level = 9;
+    sscanf(command("B").c_str(), "OK %u %u", &voltage, &level);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, level, "level unknown");
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    sim::setBattery(batteryMv, uvByMove, uvBySecond);
+    boot(0, 0);
+    RUN_TEST(test_saved_before_brownout);
+    RUN_TEST(test_resumed_with_new_batteries);
+    RUN_TEST(test_erased_thresholds);
+    return UNITY_END();
+}
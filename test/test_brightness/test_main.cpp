@@ -0,0 +1,69 @@
+// Brightness: the digits are on for disp_bright/16 of their time, disp_dim/16 after 30 s without input
+#include <stdio.h>
+#include <unity.h>
+#include "harness.h"
+
+using namespace harness;
+
+/// Part of the time the digits are on over the next second
+double dutyCycle()
+{
+    uint64_t before = sim::pinHighMicros(pinDigitEnable);
+    run(1000);
+    return (double)(sim::pinHighMicros(pinDigitEnable) - before) / 1e6;
+}
+
+/// Write a register of the config
+void writeRegister(unsigned int address, unsigned int value)
+{
+    char cmd[16];
+    snprintf(cmd, sizeof(cmd), "W %u %u", address, value);
+    command(cmd);
+}
+
+/// Part of the time the digits are on at full brightness, right after an input
+double full;
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+/// Full brightness, dimmed to 4/16 after 30 s without input, full again on a click
+void test_dimmed_when_idle()
+{
+    click();
+    full = dutyCycle();
+    TEST_ASSERT_GREATER_OR_EQUAL_MESSAGE(0.5, full, "digits on at full brightness");
+    run(28000);
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.01, full, dutyCycle(), "29 s without input");
+    run(1500);
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.01, full * 4 / 16, dutyCycle(), "dimmed after 30 s");
+    click();
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.01, full, dutyCycle(), "full again after a click");
+}
+
+/// disp_bright 8: half of the time; disp_dim 0: never dimmed
+void test_brightness_set()
+{
+    writeRegister(displayAddress, 8);
+    click();
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.01, full / 2, dutyCycle(), "brightness 8");
+    writeRegister(displayAddress + 1, 0);
+    run(31000);
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.01, full / 2, dutyCycle(), "no dimming");
+    writeRegister(displayAddress, 16);
+    writeRegister(displayAddress + 1, 4);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    boot(0, 0);
+    RUN_TEST(test_dimmed_when_idle);
+    RUN_TEST(test_brightness_set);
+    return UNITY_END();
+}
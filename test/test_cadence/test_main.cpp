@@ -0,0 +1,120 @@
+// Cadence: drift and fatigue keep the exact mean speed, the jitter is bounded and reproducible
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+#include <unity.h>
+#include "harness.h"
+
+using namespace harness;
+
+// Generator of the firmware (cadenceHelper.h), driven directly for the determinism
+namespace cadence
+{
+extern uint16_t seed;
+void start(uint32_t now, unsigned long steps);
+uint32_t nextHalfStep(uint32_t now);
+void onFootDown();
+} // namespace cadence
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+/// Set jitter, drift and fatigue (%)
+void setCadence(unsigned int jitter, unsigned int drift, unsigned int fatigue)
+{
+    char cmd[32];
+    snprintf(cmd, sizeof(cmd), "W %u %u", cadenceAddress, jitter);
+    command(cmd);
+    snprintf(cmd, sizeof(cmd), "W %u %u", cadenceAddress + 1, drift);
+    command(cmd);
+    snprintf(cmd, sizeof(cmd), "W %u %u", cadenceAddress + 2, fatigue);
+    command(cmd);
+}
+
+/// Time between the first and the last foot down of a whole session at 100 steps/min
+double sessionSpan(unsigned long steps)
+{
+    int state;
+    size_t first = sim::footDowns().size();
+    session(steps, 100, &state);
+    double span = downsSpan(first);
+    resume();
+    return span;
+}
+
+/// Drift and fatigue: 0 on the first and the last foot down, the mean step is 600 ms
+void test_exact_duration()
+{
+    setCadence(0, 10, 0);
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.5, 2999 * 600.0, sessionSpan(3000), "3000 steps, drift 10 (ms)");
+    setCadence(0, 0, 20);
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.5, 2999 * 600.0, sessionSpan(3000), "3000 steps, fatigue 20 (ms)");
+    setCadence(0, 10, 20);
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.5, 19999 * 600.0, sessionSpan(20000), "20000 steps, drift 10 and fatigue 20 (ms)");
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.5, 9 * 600.0, sessionSpan(10), "10 steps (ms)");
+}
+
+/// Jitter of 25 %: each foot down within a quarter of a half step (75 ms) of the grid, no accumulation
+void test_jitter_bounds()
+{
+    int state;
+    setCadence(25, 0, 0);
+    size_t first = sim::footDowns().size();
+    session(500, 100, &state);
+    resume();
+    const std::vector<uint64_t> &downs = sim::footDowns();
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(500, downs.size() - first, "steps");
+    double worst = 0.0;
+    for (size_t k = 1; k < 500; k++)
+    {
+        double error = (double)(downs[first + k] - downs[first]) / 1000.0 - k * 600.0;
+        worst = (fabs(error) > worst) ? fabs(error) : worst;
+    }
+    TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(150.0, worst, "worst distance to the grid (ms, both ends jittered)");
+    TEST_ASSERT_GREATER_OR_EQUAL_MESSAGE(75.0, worst, "jitter applied");
+    setCadence(0, 0, 0);
+}
+
+/// Foot down times of a session of `steps` steps from a seed (as walk() schedules them)
+std::vector<uint32_t> footDownsFrom(uint16_t seed, unsigned long steps)
+{
+    std::vector<uint32_t> downs;
+    cadence::seed = seed;
+    cadence::start(0, steps);
+    uint32_t at = 0;
+    for (unsigned long k = 0; k < steps; k++)
+    {
+        at = cadence::nextHalfStep(at); // From the foot up to the foot down
+        downs.push_back(at);
+        at = cadence::nextHalfStep(at); // From the foot down to the next foot up
+        cadence::onFootDown();
+    }
+    return downs;
+}
+
+/// Same seed, same steps; another seed, other steps
+void test_determinism()
+{
+    setCadence(25, 10, 20);
+    std::vector<uint32_t> a = footDownsFrom(0x1234, 2000);
+    std::vector<uint32_t> b = footDownsFrom(0x1234, 2000);
+    std::vector<uint32_t> c = footDownsFrom(0x4321, 2000);
+    TEST_ASSERT_TRUE_MESSAGE(a == b, "same seed");
+    TEST_ASSERT_FALSE_MESSAGE(a == c, "other seed");
+    setCadence(0, 0, 0);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    boot(0, 0);
+    RUN_TEST(test_exact_duration);
+    RUN_TEST(test_jitter_bounds);
+    RUN_TEST(test_determinism);
+    return UNITY_END();
+}
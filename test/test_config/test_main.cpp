@@ -0,0 +1,139 @@
+// Config: changes applied at once, written back later, typed fields, editor from SetSteps
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+#include "harness.h"
+
+using namespace harness;
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+/// delay_off (0x14) = 2 s: applied at once, in EEPROM after writeBackDelay
+void test_write_back()
+{
+    command("W 20 2");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(60, sim::eeprom[0x14], "EEPROM before write back");
+    run(3000);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(2, sim::eeprom[0x14], "EEPROM after write back");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(-1, status(), "powered off after 2 s");
+    resume();
+    command("W 20 60");
+}
+
+/// Out of range bytes are refused, 32-bit fields are written whole
+void test_typed_fields()
+{
+    TEST_ASSERT_EQUAL_STRING_MESSAGE("ERR\r\n", command("W 22 3").c_str(), "sync_mode 3 refused");
+    command("C 2 15000");
+    unsigned long steps = 0;
+    sscanf(command("C 2").c_str(), "OK %lu", &steps);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(15000, steps, "steps_init");
+}
+
+/// Fields depending on each other stay in order: refused, nothing changed
+void test_consistent_fields()
+{
+    TEST_ASSERT_EQUAL_STRING_MESSAGE("ERR\r\n", command("W 15 120").c_str(), "speed_min above speed_init (100)");
+    TEST_ASSERT_EQUAL_STRING_MESSAGE("ERR\r\n", command("C 2 5").c_str(), "steps_init below steps_min (10)");
+    TEST_ASSERT_EQUAL_STRING_MESSAGE("ERR\r\n", command("C 10 9").c_str(), "steps_max below steps_min (10)");
+    command("W 28 40");
+    TEST_ASSERT_EQUAL_STRING_MESSAGE("ERR\r\n", command("W 29 50").c_str(), "batt_off above batt_low");
+    TEST_ASSERT_EQUAL_STRING_MESSAGE("OK\r\n", command("W 29 255").c_str(), "batt_off 255 (never)");
+    command("W 29 0");
+    command("W 28 0");
+    unsigned long v = 0;
+    sscanf(command("R 15").c_str(), "OK %lu", &v);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(16, v, "speed_min unchanged");
+    run(3000);
+    powerUp();
+    sscanf(command("C 2").c_str(), "OK %lu", &v);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(15000, v, "config kept at power up");
+}
+
+/// Very long press in SetSteps: editor; value of address 0 + 3; long press to leave
+void test_editor()
+{
+    command("X");
+    sim::pressButton();
+    run(3500);
+    sim::releaseButton();
+    run(100);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(7, status(), "editor");
+    sim::pressButton();
+    run(100);
+    sim::releaseButton();
+    run(100);
+    sim::turnEncoder(3, 200);
+    run(100);
+    unsigned long down = 0;
+    sscanf(command("R 0").c_str(), "OK %lu", &down);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(25, down, "pos_stepdown");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(25, sim::servo().position, "servo position");
+    sim::pressButton();
+    run(1500);
+    sim::releaseButton();
+    run(100);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(1, status(), "left to SetSteps");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(25, sim::eeprom[0], "EEPROM");
+}
+
+/// Config of the first firmware (16-bit step counts, no version): converted at power up
+void test_first_firmware()
+{
+    const uint8_t first[] = {30, 120, 0xd0, 0x07, 10, 0, 0x20, 0x4e, 90, 16, 200, 50, 10, 15, 45, 50};
+    memset(sim::eeprom, 0xff, sim::eepromSize);
+    memcpy(sim::eeprom, first, sizeof(first));
+    powerUp();
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(configVersion, sim::eeprom[versionAddress], "version written");
+    unsigned long v = 0;
+    sscanf(command("C 2").c_str(), "OK %lu", &v);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(2000, v, "steps_init");
+    sscanf(command("C 10").c_str(), "OK %lu", &v);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(20000, v, "steps_max");
+    sscanf(command("R 16").c_str(), "OK %lu", &v);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(200, v, "speed_max");
+    sscanf(command("R 20").c_str(), "OK %lu", &v);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(45, v, "delay_off");
+    sscanf(command("R 22").c_str(), "OK %lu", &v);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, v, "sync_mode (default)");
+    sscanf(command("R 28").c_str(), "OK %lu", &v);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, v, "batt_low (default)");
+}
+
+/// Blank EEPROM, unknown version or invalid config: default config
+void test_blank()
+{
+    unsigned long v = 0;
+    memset(sim::eeprom, 0xff, sim::eepromSize);
+    powerUp();
+    sscanf(command("C 10").c_str(), "OK %lu", &v);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(1000000, v, "steps_max of a blank EEPROM");
+    sim::eeprom[versionAddress] = configVersion + 1;
+    sim::eeprom[0] = 40;
+    powerUp();
+    sscanf(command("R 0").c_str(), "OK %lu", &v);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(22, v, "pos_stepdown of an unknown version");
+    sim::eeprom[0] = 200;
+    powerUp();
+    sscanf(command("R 0").c_str(), "OK %lu", &v);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(22, v, "pos_stepdown out of range");
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    boot(0, 0);
+    RUN_TEST(test_write_back);
+    RUN_TEST(test_typed_fields);
+    RUN_TEST(test_consistent_fields);
+    RUN_TEST(test_editor);
+    RUN_TEST(test_first_firmware);
+    RUN_TEST(test_blank);
+    return UNITY_END();
+}
@@ -0,0 +1,93 @@
+// Display: numbers in thousands above 99999, their decimal point over the status dots
+#include <stdio.h>
+#include <unity.h>
+#include "harness.h"
+
+using namespace harness;
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+/// Set the steps and let the display show them
+std::string showSteps(unsigned long steps)
+{
+    char cmd[32];
+    snprintf(cmd, sizeof(cmd), "S %lu", steps);
+    command(cmd);
+    run(50);
+    return sim::displayText();
+}
+
+/// Up to 99999: units, with the step dot on the right digit
+void test_units()
+{
+    TEST_ASSERT_EQUAL_STRING_MESSAGE("  100.", showSteps(100).c_str(), "100");
+    TEST_ASSERT_EQUAL_STRING_MESSAGE("99999.", showSteps(99999).c_str(), "99999");
+}
+
+/// Thousands: the decimal point stays on the speed and step digits
+void test_thousands()
+{
+    command("C 10 99999999");
+    TEST_ASSERT_EQUAL_STRING_MESSAGE("1234.5.", showSteps(1234500).c_str(), "1234500 (point on the speed dot)");
+    TEST_ASSERT_EQUAL_STRING_MESSAGE("12345.", showSteps(12345000).c_str(), "12345000 (point on the step dot)");
+    TEST_ASSERT_EQUAL_STRING_MESSAGE("99999.", showSteps(99999999).c_str(), "99999999");
+}
+
+/// 123450: the point is on the time dot, cleared by the steps display
+void test_point_on_time_dot()
+{
+    TEST_ASSERT_EQUAL_STRING_MESSAGE("123.45.", showSteps(123450).c_str(), "123450");
+}
+
+/// Session by duration: minutes and seconds, the time dot between them
+void test_time_left()
+{
+    command("S 3m");
+    run(50);
+    TEST_ASSERT_EQUAL_STRING_MESSAGE("  3.00", sim::displayText().c_str(), "3 minutes");
+    showSteps(1000);
+}
+
+/// Back to units: the point is gone, the status dots are back
+void test_back_to_units()
+{
+    showSteps(1234500);
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(" 1000.", showSteps(1000).c_str(), "1000");
+}
+
+/// Cursor moved right from the units: wraps to the leftmost digit (tens of thousands)
+void test_cursor_wraps()
+{
+    int state;
+    showSteps(1000);
+    click();
+    for (int i = 0; i < 4; i++)
+    { // From the thousands to the units, then around
+        click();
+    }
+    unsigned long steps = remainingSteps(&state);
+    sim::turnEncoder(1);
+    run(300);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(steps + 10000, remainingSteps(&state), "one detent on the leftmost digit");
+    command("X");
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    sim::followDisplay(true);
+    boot(0, 0);
+    RUN_TEST(test_units);
+    RUN_TEST(test_thousands);
+    RUN_TEST(test_point_on_time_dot);
+    RUN_TEST(test_time_left);
+    RUN_TEST(test_back_to_units);
+    RUN_TEST(test_cursor_wraps);
+    return UNITY_END();
+}
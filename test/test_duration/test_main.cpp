@@ -0,0 +1,97 @@
+// Session by duration: the speed changed half way, the steps follow the time; set from the button
+#include <math.h>
+#include <stdio.h>
+#include <unity.h>
+#include "harness.h"
+
+using namespace harness;
+
+/// Session of 3 minutes at 160 steps/min, then 106 steps/min half way
+const unsigned long minutes = 3;
+const unsigned long speed = 160;
+const unsigned long slower = speed * 2 / 3;
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+/// The session ends on time, with the steps of each speed
+void test_speed_changed_half_way()
+{
+    char cmd[32];
+    snprintf(cmd, sizeof(cmd), "S %lum", minutes);
+    command(cmd);
+    snprintf(cmd, sizeof(cmd), "V %lu", speed);
+    command(cmd);
+    size_t first = sim::footDowns().size();
+    uint64_t startedAt = sim::now();
+    command("G");
+    run(minutes * 30000);
+    uint64_t changedAt = sim::now();
+    size_t half = sim::footDowns().size() - first;
+    snprintf(cmd, sizeof(cmd), "V %lu", slower);
+    command(cmd);
+    int state;
+    do
+    {
+        run(1000);
+        state = status();
+    } while ((state != 6) && (sim::now() - startedAt < minutes * 66000000ULL));
+    TEST_ASSERT_EQUAL_INT_MESSAGE(6, state, "finished");
+    double expected = half + (minutes * 60.0 - (double)(changedAt - startedAt) / 1e6) * slower / 60.0;
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(1.0, expected, (double)(sim::footDowns().size() - first), "steps");
+    double last = (double)(sim::footDowns().back() - startedAt) / 1e6;
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(60.0 / slower, minutes * 60.0, last, "last step (s)");
+}
+
+/// Button: counterclockwise from the steps, click, +1 on the tens of minutes
+void test_set_from_button()
+{
+    int state;
+    command("X");
+    sim::turnEncoder(-1, 200);
+    run(100);
+    sim::pressButton();
+    run(80);
+    sim::releaseButton();
+    run(100);
+    sim::turnEncoder(1, 200);
+    run(2000);
+    command("G");
+    run(100);
+    TEST_ASSERT_INT_WITHIN_MESSAGE(1, (minutes + 10) * 100, remainingSteps(&state), "steps of the budget");
+}
+
+/// Button: the two last digits change the seconds, +10 s then -1 s
+void test_seconds_from_button()
+{
+    int state;
+    command("X");
+    sim::turnEncoder(-1, 200);
+    run(100);
+    click(); // Cursor on the tens of minutes
+    click();
+    click(); // Tens of seconds
+    sim::turnEncoder(1, 200);
+    run(300);
+    click(); // Seconds
+    sim::turnEncoder(-1, 200);
+    run(2000);
+    command("G");
+    run(100);
+    TEST_ASSERT_INT_WITHIN_MESSAGE(1, ((minutes + 10) * 60 + 9) * 100 / 60, remainingSteps(&state), "steps of the budget");
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    boot(0, 0);
+    RUN_TEST(test_speed_changed_half_way);
+    RUN_TEST(test_set_from_button);
+    RUN_TEST(test_seconds_from_button);
+    return UNITY_END();
+}
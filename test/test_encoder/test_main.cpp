@@ -0,0 +1,73 @@
+// Encoder: slow turns and flicks while setting the steps and changing the speed
+#include <stdio.h>
+#include <unity.h>
+#include "harness.h"
+
+using namespace harness;
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+/// Speed (from the status command)
+unsigned long speed()
+{
+    int state;
+    unsigned long steps;
+    unsigned long speed = 0;
+    std::string s = command("?");
+    sscanf(s.c_str() + s.rfind("OK "), "OK %d %lu %lu", &state, &steps, &speed);
+    return speed;
+}
+
+/// Short click: adjust the digit of the thousands, one detent at a time, then flicks
+void test_steps()
+{
+    int state;
+    unsigned long steps = remainingSteps(&state);
+    click();
+    for (int i = 0; i < 5; i++)
+    {
+        sim::turnEncoder(1);
+        run(300);
+    }
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(steps + 5000, remainingSteps(&state), "5 slow detents");
+    sim::turnEncoder(10, 15);
+    run(300);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(steps + 505000, remainingSteps(&state), "flick of 10 (in thousands from 100000)");
+    sim::turnEncoder(-10, 15);
+    run(300);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(steps + 5000, remainingSteps(&state), "flick of -10, still on the thousands");
+}
+
+/// Speed changed while walking: one by detent when slow, faster on a flick
+void test_speed()
+{
+    command("S 1000");
+    command("V 100");
+    command("G");
+    run(1000);
+    sim::turnEncoder(1);
+    run(300);
+    sim::turnEncoder(1);
+    run(300);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(101, speed(), "2 slow detents");
+    sim::turnEncoder(8, 15);
+    run(300);
+    sim::turnEncoder(-40, 10);
+    run(300);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(16, speed(), "flick of -40: lowest speed");
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    boot(0, 0);
+    RUN_TEST(test_steps);
+    RUN_TEST(test_speed);
+    return UNITY_END();
+}
@@ -0,0 +1,118 @@
+// Energy: the counters of E follow the states, the servo, the display and the buzzer of the board
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <unity.h>
+#include "harness.h"
+
+using namespace harness;
+
+/// Counters of E: ms in each state (from PowerOff), servo, display, buzzer (ms) and steps
+struct Energy
+{
+    std::vector<double> states;
+    double servo;
+    double display;
+    double buzzer;
+    double steps;
+};
+
+/// Read the counters (E), or read and reset them (E 0). Fields left at -1 if missing.
+Energy readEnergy(const char *cmd)
+{
+    std::string answer = command(cmd);
+    std::vector<double> values;
+    const char *p = answer.c_str();
+    if (answer.compare(0, 2, "OK") == 0)
+    {
+        p += 2;
+        char *end;
+        for (double v = strtod(p, &end); end != p; v = strtod(p, &end))
+        {
+            values.push_back(v);
+            p = end;
+        }
+    }
+    values.resize(13, -1.0);
+    Energy e;
+    e.states.assign(values.begin(), values.begin() + 9);
+    e.servo = values[9];
+    e.display = values[10];
+    e.buzzer = values[11];
+    e.steps = values[12];
+    return e;
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+/// A session of 20 steps: each counter against the board (±5 ms for the commands)
+void test_session_counted()
+{
+    resume();
+    readEnergy("E 0");
+    uint64_t startedAt = sim::now();
+    sim::ServoRecord servo = sim::servo();
+    uint64_t displayUs = sim::pinHighMicros(pinDigitEnable);
+    uint64_t buzzerUs = sim::pinHighMicros(pinBuzzer);
+    int state;
+    session(20, 60, &state);
+    Energy e = readEnergy("E");
+    double total = 0.0;
+    for (double ms : e.states)
+    {
+        total += ms;
+    }
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(5.0, (sim::now() - startedAt) / 1000.0, total, "time of all the states (ms)");
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(1000.0, 19000.0, e.states[1 + 3], "time walking (ms)");
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(5.0, (sim::servo().attachedUs - servo.attachedUs) / 1000.0, e.servo,
+                                     "servo attached (ms)");
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(5.0, (sim::pinHighMicros(pinDigitEnable) - displayUs) / 1000.0, e.display,
+                                     "display on (ms)");
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(1.0, (sim::pinHighMicros(pinBuzzer) - buzzerUs) / 1000.0, e.buzzer,
+                                     "buzzer on (ms)");
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.5, 20.0, e.steps, "steps");
+}
+
+/// Idle for 40 s, dimmed after 30 s: the display counts ms at full brightness
+void test_display_dimmed()
+{
+    readEnergy("E 0");
+    uint64_t displayUs = sim::pinHighMicros(pinDigitEnable);
+    run(40000);
+    Energy e = readEnergy("E");
+    double on = (sim::pinHighMicros(pinDigitEnable) - displayUs) / 1000.0;
+    TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(35000.0, on, "dimmed");
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(5.0, on, e.display, "display on (ms)");
+}
+
+/// E 0 starts the counters again, E with another number is refused
+void test_reset()
+{
+    readEnergy("E 0");
+    Energy e = readEnergy("E");
+    double total = 0.0;
+    for (double ms : e.states)
+    {
+        total += ms;
+    }
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(10.0, 0.0, total, "time counted since E 0 (ms)");
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.5, 0.0, e.steps, "steps since E 0");
+    TEST_ASSERT_EQUAL_STRING_MESSAGE("ERR\r\n", command("E 1").c_str(), "E 1");
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    boot(0, 0);
+    RUN_TEST(test_session_counted);
+    RUN_TEST(test_display_dimmed);
+    RUN_TEST(test_reset);
+    return UNITY_END();
+}
@@ -0,0 +1,70 @@
+// Emergency stop: no servo move from the press of the button, a glitch on its line goes on
+#include <unity.h>
+#include "Arduino.h"
+#include "harness.h"
+
+using namespace harness;
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+/// Long press: frozen from the press, stopped on release
+void test_long_press()
+{
+    command("S 1000");
+    command("V 200");
+    command("G");
+    run(5030);
+    unsigned long writes = sim::servo().writes;
+    sim::pressButton();
+    run(1500);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, sim::servo().writes - writes, "moves while held");
+    sim::releaseButton();
+    run(100);
+    int state = status();
+    TEST_ASSERT_TRUE_MESSAGE((state == 0) || (state == 1), "stopped");
+}
+
+/// Short click: frozen from the press, paused on release
+void test_click()
+{
+    command("V 200");
+    command("G");
+    run(5070);
+    unsigned long writes = sim::servo().writes;
+    sim::pressButton();
+    run(200);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, sim::servo().writes - writes, "moves while held");
+    sim::releaseButton();
+    run(100);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(4, status(), "paused");
+}
+
+/// Glitch of 50 us (not seen by the main loop): still walking, the steps shifted by a few ms
+void test_glitch()
+{
+    command("G");
+    run(5010);
+    size_t first = sim::footDowns().size();
+    sim::setPin(pinButton, LOW);
+    sim::advanceMicros(50);
+    sim::setPin(pinButton, HIGH);
+    run(10000);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(3, status(), "still walking");
+    TEST_ASSERT_GREATER_OR_EQUAL_MESSAGE(32, sim::footDowns().size() - first, "steps in 10 s");
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    boot(0, 0);
+    RUN_TEST(test_long_press);
+    RUN_TEST(test_click);
+    RUN_TEST(test_glitch);
+    return UNITY_END();
+}
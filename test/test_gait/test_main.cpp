@@ -0,0 +1,53 @@
+// Recorded gait: the decoded trace stays in the stroke, reaches both ends and counts its foot strikes as steps
+#include <stdio.h>
+#include <unity.h>
+#include "harness.h"
+
+using namespace harness;
+
+/// Servo positions of the default config
+const int posDown = 22;
+const int posUp = 130;
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+/// 230 steps (10 loops of the trace) at 105 steps/min, the servo sampled at each frame
+void test_replay()
+{
+    char cmd[32];
+    snprintf(cmd, sizeof(cmd), "W %d 1", gaitReplayAddress);
+    command(cmd);
+    command("S 230");
+    command("V 105");
+    uint64_t startedAt = sim::now();
+    command("G");
+    int lowest = 255;
+    int highest = -1;
+    int state;
+    do
+    {
+        run(20);
+        int position = sim::servo().position;
+        lowest = (position < lowest) ? position : lowest;
+        highest = (position > highest) ? position : highest;
+    } while (((state = status()) != 6) && (sim::now() - startedAt < 200000000ULL));
+    TEST_ASSERT_EQUAL_INT_MESSAGE(6, state, "finished");
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(1.0, 230 * 60.0 / 105, (double)(sim::now() - startedAt) / 1e6, "duration (s)");
+    TEST_ASSERT_INT_WITHIN_MESSAGE(2, posDown, lowest, "lowest position");
+    TEST_ASSERT_INT_WITHIN_MESSAGE(5, posUp, highest, "highest position");
+    TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(posUp, highest, "in the stroke");
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    boot(0, 0);
+    RUN_TEST(test_replay);
+    return UNITY_END();
+}
@@ -0,0 +1,163 @@
+// Input trace: a session recorded with J and replayed from power up ends in the same state
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <unity.h>
+#include "Arduino.h"
+#include "harness.h"
+
+using namespace harness;
+
+/// Board time of the final status (ms)
+const uint64_t endAt = 30000;
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+/// Press the button at the next whole ms (as replayed) for some ms
+void press(unsigned long ms)
+{
+    uint64_t at = (sim::now() / 1000 + 1) * 1000;
+    sim::schedulePin(at, pinButton, LOW);
+    sim::schedulePin(at + (uint64_t)ms * 1000, pinButton, HIGH);
+    run(ms + 1);
+}
+
+/// Turn the encoder from the next whole ms, one detent every intervalMs (some within the debounce time)
+void spin(int detents, unsigned long intervalMs)
+{
+    uint64_t at = (sim::now() / 1000 + 1) * 1000;
+    for (int k = 0; k < abs(detents); k++)
+    {
+        sim::schedulePin(at, pinEncoderB, (detents < 0) ? HIGH : LOW);
+        sim::schedulePin(at, pinEncoderA, LOW);
+        sim::schedulePin(at + (uint64_t)intervalMs * 500, pinEncoderA, HIGH);
+        at += (uint64_t)intervalMs * 1000;
+    }
+    sim::schedulePin(at, pinEncoderB, HIGH);
+    run(abs(detents) * intervalMs + 1);
+}
+
+/// Drain the trace (J) into `bytes`
+void drain(std::vector<uint8_t> *bytes)
+{
+    while (appendTrace(command("J"), bytes))
+    {
+    }
+}
+
+/// State changes of a trace
+std::vector<uint8_t> states(const std::vector<InputEvent> &events)
+{
+    std::vector<uint8_t> codes;
+    for (const InputEvent &e : events)
+    {
+        if ((e.code & 0xc0) == 0x80)
+        {
+            codes.push_back(e.code);
+        }
+    }
+    return codes;
+}
+
+/// Record a session from power up: trace bytes, then the final status
+void record(int fd)
+{
+    std::vector<uint8_t> bytes;
+    boot(0, 0);
+    // Steps: click, fast spins both ways, then walk (long press)
+    press(80);
+    run(100);
+    spin(20, 3);
+    run(300);
+    spin(-7, 40);
+    run(2000);
+    drain(&bytes);
+    press(1003);
+    run(3000);
+    drain(&bytes);
+    // Speed changed while walking, pause and go on
+    spin(5, 30);
+    run(1500);
+    press(120);
+    run(1000);
+    press(90);
+    run(2000);
+    drain(&bytes);
+    runUntil(endAt * 1000);
+    drain(&bytes);
+    std::string status = command("?");
+    size_t size = bytes.size();
+    if ((write(fd, &size, sizeof(size)) != sizeof(size)) || (write(fd, bytes.data(), size) != (ssize_t)size)
+        || (write(fd, status.c_str(), status.size()) != (ssize_t)status.size()))
+    {
+        _exit(1);
+    }
+}
+
+/// Replay on a board powered up at the same time: same changes of state, same steps and speed
+void test_replay()
+{
+    int fds[2];
+    TEST_ASSERT_EQUAL_INT_MESSAGE(0, pipe(fds), "pipe");
+    pid_t pid = fork();
+    if (pid == 0)
+    { // Recording board
+        close(fds[0]);
+        record(fds[1]);
+        _exit(0);
+    }
+    close(fds[1]);
+    size_t size = 0;
+    std::vector<uint8_t> bytes;
+    if (read(fds[0], &size, sizeof(size)) == sizeof(size))
+    {
+        bytes.resize(size);
+        size_t got = 0;
+        ssize_t n;
+        while ((got < size) && ((n = read(fds[0], bytes.data() + got, size - got)) > 0))
+        {
+            got += n;
+        }
+    }
+    std::string expected;
+    char buffer[64];
+    ssize_t n;
+    while ((n = read(fds[0], buffer, sizeof(buffer))) > 0)
+    {
+        expected.append(buffer, n);
+    }
+    close(fds[0]);
+    waitpid(pid, nullptr, 0);
+    std::vector<InputEvent> recorded = decodeTrace(bytes);
+    TEST_ASSERT_GREATER_OR_EQUAL_MESSAGE(40, recorded.size(), "events recorded");
+
+    // Replaying board
+    memset(sim::eeprom, 0xff, sim::eepromSize);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, scheduleInputs(recorded), "events lost");
+    powerUp();
+    std::vector<uint8_t> replayed;
+    while (sim::boardMillis() < endAt - 100)
+    {
+        run(100);
+        drain(&replayed);
+    }
+    runUntil(endAt * 1000);
+    drain(&replayed);
+    TEST_ASSERT_TRUE_MESSAGE(states(recorded) == states(decodeTrace(replayed)), "same changes of state");
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(expected.c_str(), command("?").c_str(), "same state, steps and speed");
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_replay);
+    return UNITY_END();
+}
@@ -0,0 +1,84 @@
+// Servo gating: released between two half steps once settled, re-attached just before the next one
+#include <stdio.h>
+#include <unity.h>
+#include "harness.h"
+
+using namespace harness;
+
+/// Servo activity while walking 10 steps at some speed (after 3 s to start)
+sim::ServoRecord walkServo(unsigned long speed)
+{
+    char cmd[16];
+    resume();
+    command("S 1000");
+    snprintf(cmd, sizeof(cmd), "V %lu", speed);
+    command(cmd);
+    command("G");
+    run(3000);
+    sim::ServoRecord before = sim::servo();
+    run(10 * 60000 / speed);
+    sim::ServoRecord after = sim::servo();
+    command("X");
+    run(100);
+    sim::ServoRecord r = after;
+    r.writes -= before.writes;
+    r.attaches -= before.attaches;
+    r.attachedUs -= before.attachedUs;
+    return r;
+}
+
+/// Set the settle time of the servo (10 ms)
+void setSettle(unsigned int settle)
+{
+    char cmd[16];
+    snprintf(cmd, sizeof(cmd), "W %u %u", servoSettleAddress, settle);
+    command(cmd);
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+/// 60 steps/min (500 ms by half step): attached for the settle time (250 ms) and the re-arm lead (40 ms)
+void test_released_between_half_steps()
+{
+    sim::ServoRecord r = walkServo(60);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(20, r.writes, "half steps");
+    TEST_ASSERT_UINT32_WITHIN_MESSAGE(1, 20, r.attaches, "re-attached at each half step");
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(20 * 3.0, 20 * 291.0, r.attachedUs / 1000.0, "attached (ms)");
+}
+
+/// 80 steps/min (375 ms by half step): once settled, 125 ms are left, less than the re-arm lead
+/// and the shortest release (140 ms): kept attached. 70 steps/min (428 ms): 178 ms left, released.
+void test_shortest_release()
+{
+    sim::ServoRecord r = walkServo(80);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, r.attaches, "kept attached at 80 steps/min");
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(1.0, 7500.0, r.attachedUs / 1000.0, "attached (ms)");
+    r = walkServo(70);
+    TEST_ASSERT_UINT32_WITHIN_MESSAGE(1, 20, r.attaches, "released at 70 steps/min");
+}
+
+/// Settle time 0: never released
+void test_gating_off()
+{
+    setSettle(0);
+    sim::ServoRecord r = walkServo(60);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, r.attaches, "never released");
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(1.0, 10000.0, r.attachedUs / 1000.0, "attached (ms)");
+    setSettle(25);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    boot(0, 0);
+    RUN_TEST(test_released_between_half_steps);
+    RUN_TEST(test_shortest_release);
+    RUN_TEST(test_gating_off);
+    return UNITY_END();
+}
@@ -0,0 +1,88 @@
+// Sessions driven by serial commands: steps set by hand and a workout program
+#include <unity.h>
+#include "harness.h"
+
+using namespace harness;
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+/// 2000 steps at 100 steps/min: every step done, at the exact cadence
+void test_steps()
+{
+    int state;
+    size_t first = sim::footDowns().size();
+    unsigned long remaining = session(2000, 100, &state);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, remaining, "steps remaining");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(2000, sim::footDowns().size() - first, "steps");
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(2.0, 1999 * 600.0, downsSpan(first), "duration (ms)");
+}
+
+/// 500 steps at 80 then 200 steps at 160 (the new speed applies from the foot up after the last step at 80)
+void test_program()
+{
+    int state;
+    command("X");
+    loadProgram("01f4015001c800a000");
+    size_t first = sim::footDowns().size();
+    session(0, 0, &state);
+    command("L 0");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(700, sim::footDowns().size() - first, "steps");
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(5.0, 499 * 750.0 + 375.0 + 187.5 + 199 * 375.0, downsSpan(first), "duration (ms)");
+}
+
+/// Programs are not written while one runs, even paused
+void test_program_locked()
+{
+    command("X");
+    loadProgram("01f4015001c800a000");
+    command("G");
+    run(2000);
+    TEST_ASSERT_EQUAL_STRING_MESSAGE("ERR\r\n", command("M 0 00").c_str(), "walking");
+    command("P");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(4, status(), "paused");
+    TEST_ASSERT_EQUAL_STRING_MESSAGE("ERR\r\n", command("M 0 00").c_str(), "paused");
+    command("X");
+    TEST_ASSERT_EQUAL_STRING_MESSAGE("OK\r\n", command("M 0 01").c_str(), "stopped");
+    command("L 0");
+}
+
+/// Session stopped half way (X), then a new one: its own fatigue curve, the servo released in between
+void test_restart()
+{
+    int state;
+    resume();
+    command("W 26 20");
+    command("S 200");
+    command("V 100");
+    command("G");
+    run(60000);
+    command("X");
+    uint64_t attached = sim::servo().attachedUs;
+    run(2000);
+    TEST_ASSERT_TRUE_MESSAGE(sim::servo().attachedUs == attached, "servo released once stopped");
+    size_t first = sim::footDowns().size();
+    session(200, 100, &state);
+    const std::vector<uint64_t> &downs = sim::footDowns();
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(200, downs.size() - first, "steps");
+    double firstHalf = (double)(downs[first + 100] - downs[first]) / 100000.0;
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(5.0, 540.0, firstHalf, "first half 10 % faster (mean period, ms)");
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(2.0, 199 * 600.0, downsSpan(first), "duration (ms)");
+    command("W 26 0");
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    boot(0, 0);
+    RUN_TEST(test_steps);
+    RUN_TEST(test_program);
+    RUN_TEST(test_program_locked);
+    RUN_TEST(test_restart);
+    return UNITY_END();
+}
@@ -0,0 +1,98 @@
+// Step log: every foot down is logged at its time and gives a pulse; steps not drained in time are reported lost
+#include <math.h>
+#include <stdio.h>
+#include <unity.h>
+#include "Arduino.h"
+#include "harness.h"
+
+using namespace harness;
+
+/// Time (board ms) of each logged step, by number
+std::vector<std::pair<unsigned long, uint64_t>> logged;
+/// Steps of the first session
+size_t done;
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+/// Drain the step log
+void drainStepLog()
+{
+    while (true)
+    {
+        std::string answer = command("T");
+        unsigned long index;
+        unsigned long at;
+        int used;
+        const char *p = answer.c_str();
+        if (sscanf(p, "OK %lu %lu%n", &index, &at, &used) != 2)
+        {
+            return;
+        }
+        logged.push_back(std::make_pair(index, (uint64_t)at));
+        p += used;
+        unsigned long delta;
+        while (sscanf(p, " %lu%n", &delta, &used) == 1)
+        {
+            at += delta;
+            logged.push_back(std::make_pair(++index, (uint64_t)at));
+            p += used;
+        }
+    }
+}
+
+/// 300 steps at 100 steps/min, drained every second: all logged at their time, pulses of 5 ms
+void test_drained()
+{
+    command("S 300");
+    command("V 100");
+    uint64_t pulseFrom = sim::pinHighMicros(A1);
+    size_t first = sim::footDowns().size();
+    command("G");
+    do
+    {
+        run(1000);
+        drainStepLog();
+    } while (status() != 6);
+    const std::vector<uint64_t> &downs = sim::footDowns();
+    done = downs.size() - first;
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(done, logged.size(), "logged steps");
+    double worst = 0.0;
+    for (size_t k = 0; (k < logged.size()) && (k < done); k++)
+    {
+        double error = fabs((double)logged[k].second - (double)downs[first + k] / 1000.0);
+        worst = (error > worst) ? error : worst;
+    }
+    TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(1.0, worst, "worst time error (ms)");
+    // Ended by the main loop on the next tick of millis()
+    double pulse = (double)(sim::pinHighMicros(A1) - pulseFrom) / 1000.0 / done;
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.5, 5.5, pulse, "mean pulse (ms)");
+}
+
+/// 100 steps at 100 steps/min, drained once after 60 s: only the last 32 are kept
+void test_undrained()
+{
+    command("X");
+    command("S 100");
+    command("V 100");
+    command("G");
+    logged.clear();
+    run(61000);
+    drainStepLog();
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(32, logged.size(), "steps kept");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(100 - 32, logged.front().first - (done + 1), "steps lost");
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    boot(0, 0);
+    RUN_TEST(test_drained);
+    RUN_TEST(test_undrained);
+    return UNITY_END();
+}
@@ -0,0 +1,90 @@
+// Synchronization: a follower executes the commands of the master, ignores its answers and locks on its beacons
+#include <math.h>
+#include <unity.h>
+#include "harness.h"
+
+using namespace harness;
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+/// Answers of the master: not taken for commands (`ERR` is not `E`), not answered
+void test_answers_ignored()
+{
+    TEST_ASSERT_EQUAL_STRING_MESSAGE("", command("OK").c_str(), "OK");
+    TEST_ASSERT_EQUAL_STRING_MESSAGE("", command("ERR").c_str(), "ERR");
+    TEST_ASSERT_EQUAL_STRING_MESSAGE("", command("OK 3 1000 100").c_str(), "status answer");
+}
+
+/// Commands of the master mixed with its answers: the follower walks
+void test_commands_followed()
+{
+    sim::serialInput("S 1000\r\nOK\r\nV 120\r\nOK\r\nG\r\nOK\r\n");
+    run(6000);
+    int state;
+    unsigned long remaining = remainingSteps(&state);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(3, state, "walking");
+    TEST_ASSERT_TRUE_MESSAGE((remaining > 0) && (remaining < 1000), "steps remaining");
+}
+
+/// Beacons of a master 230 ms after the foot downs of the follower (120 steps/min: 500 ms by step):
+/// each beacon corrects half of the error, so no step changes by more than a quarter of a step,
+/// and the foot downs end on the ones of the master (within 1 ms to fire the step and 1 ms left by the halving)
+void test_phase_locked()
+{
+    const uint64_t period = 500000;
+    size_t first = sim::footDowns().size();
+    while (sim::footDowns().size() == first)
+    {
+        run(1);
+    }
+    uint64_t masterAt = sim::footDowns().back() + 230000;
+    std::vector<uint64_t> master;
+    for (int k = 0; k < 20; k++)
+    {
+        runUntil(masterAt); // Received sync::beaconLatency later
+        sim::serialInput("Y\r\n");
+        master.push_back(masterAt);
+        masterAt += period;
+    }
+    run(100);
+    const std::vector<uint64_t> &downs = sim::footDowns();
+    double shortest = 1e9;
+    double longest = 0.0;
+    for (size_t k = first + 1; k < downs.size(); k++)
+    {
+        double step = (double)(downs[k] - downs[k - 1]) / 1000.0;
+        shortest = (step < shortest) ? step : shortest;
+        longest = (step > longest) ? step : longest;
+    }
+    TEST_ASSERT_GREATER_OR_EQUAL_MESSAGE(500.0 - 125.0 - 1.0, shortest, "shortest step (ms)");
+    TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(500.0 + 125.0 + 1.0, longest, "longest step (ms)");
+    // Phase error on the last 5 beacons, against the closest foot down of the follower
+    double worst = 0.0;
+    for (size_t k = master.size() - 5; k < master.size(); k++)
+    {
+        double closest = 1e9;
+        for (size_t d = first; d < downs.size(); d++)
+        {
+            double error = fabs((double)downs[d] - (double)master[k]) / 1000.0;
+            closest = (error < closest) ? error : closest;
+        }
+        worst = (closest > worst) ? closest : worst;
+    }
+    TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(2.0, worst, "phase error after 15 beacons (ms)");
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    boot(2, 0);
+    RUN_TEST(test_answers_ignored);
+    RUN_TEST(test_commands_followed);
+    RUN_TEST(test_phase_locked);
+    return UNITY_END();
+}
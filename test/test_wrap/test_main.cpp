@@ -0,0 +1,81 @@
+// Wraps of millis() (every 49.7 days): a session, a program pause, the power off timeout and a click across a wrap
+#include <math.h>
+#include <unity.h>
+#include "harness.h"
+
+using namespace harness;
+
+/// Period of millis() (ms)
+const uint64_t wrapMs = 1ULL << 32;
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+/// Session of 100 steps at 100 steps/min, from 30 s before the first wrap
+void test_session_across_wrap()
+{
+    int state;
+    sim::advanceToBoardMillis(wrapMs - 30000);
+    resume();
+    size_t first = sim::footDowns().size();
+    unsigned long remaining = session(100, 100, &state);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, remaining, "steps remaining");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(100, sim::footDowns().size() - first, "steps");
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(2.0, 99 * 600.0, downsSpan(first), "duration (ms)");
+}
+
+/// 10 steps, a pause of 40 s (longer than 16 bits of ms) across the second wrap, 10 steps
+void test_program_pause_across_wrap()
+{
+    int state;
+    sim::advanceToBoardMillis(2 * wrapMs - 10000);
+    resume();
+    loadProgram("010a0064032800010a006400");
+    size_t first = sim::footDowns().size();
+    session(0, 0, &state);
+    command("L 0");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(20, sim::footDowns().size() - first, "steps");
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(5.0, 51100.0, downsSpan(first), "duration (ms)");
+}
+
+/// Power off after 60 s without interaction, from 20 s before the third wrap
+void test_timeout_across_wrap()
+{
+    sim::advanceToBoardMillis(3 * wrapMs - 20000);
+    resume();
+    run(50000);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(1, status(), "state after 50 s");
+    run(12000);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(-1, status(), "state after 62 s");
+}
+
+/// Click of 200 ms while walking, across the fourth wrap: paused (a long press would stop)
+void test_click_across_wrap()
+{
+    sim::advanceToBoardMillis(4 * wrapMs - 20000);
+    resume();
+    command("S 1000");
+    command("G");
+    sim::advanceToBoardMillis(4 * wrapMs - 100);
+    sim::pressButton();
+    run(200);
+    sim::releaseButton();
+    run(100);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(4, status(), "paused");
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    boot(0, 0);
+    RUN_TEST(test_session_across_wrap);
+    RUN_TEST(test_program_pause_across_wrap);
+    RUN_TEST(test_timeout_across_wrap);
+    RUN_TEST(test_click_across_wrap);
+    return UNITY_END();
+}